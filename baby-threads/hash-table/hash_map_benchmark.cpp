@@ -0,0 +1,82 @@
+// Mixed workload benchmark of ConcurrentHashMap and LockFreeHashMap. Not part
+// of a build target:
+//   g++ -std=c++20 -O2 -pthread hash_map_benchmark.cpp -o hash_map_benchmark
+//   ./hash_map_benchmark [max threads] [find percent] [keys]
+//
+// Every thread runs the same number of operations on keys drawn uniformly from
+// [0, keys): Find with the given probability, otherwise Insert or Erase with
+// equal odds, so the map stays about half full. Thread counts double up to the
+// maximum, which may exceed the hardware threads to oversubscribe the maps.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "concurrent_hash_map.h"
+#include "lock_free_hash_map.h"
+
+namespace {
+
+constexpr int kOperationsPerThread = 1 << 20;
+
+template <class Map>
+double Run(int threads, int find_percent, int keys) {
+    Map map(keys);
+    for (int key = 0; key < keys; key += 2) {
+        map.Insert(key, key);
+    }
+
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&map, i, find_percent, keys] {
+            std::mt19937 rng(i);
+            int64_t found = 0;
+            for (int j = 0; j < kOperationsPerThread; ++j) {
+                auto key = static_cast<int>(rng() % keys);
+                auto percent = static_cast<int>(rng() % 100);
+                if (percent < find_percent) {
+                    found += map.Find(key).first;
+                } else if (percent % 2 == 0) {
+                    map.Insert(key, key);
+                } else {
+                    map.Erase(key);
+                }
+            }
+            if (found < 0) {
+                std::abort();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return threads * kOperationsPerThread / elapsed.count() / 1e6;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    auto hardware_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    auto max_threads = argc > 1 ? std::atoi(argv[1]) : 2 * hardware_threads;
+    auto find_percent = argc > 2 ? std::atoi(argv[2]) : 80;
+    auto keys = argc > 3 ? std::atoi(argv[3]) : 1 << 17;
+    if (max_threads < 1 || find_percent < 0 || find_percent > 100 || keys < 1) {
+        std::fprintf(stderr, "usage: %s [max threads] [find percent] [keys]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("%d%% Find, %d keys, Mops/s\n", find_percent, keys);
+    std::printf("%8s %12s %12s\n", "threads", "striped", "lock-free");
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        std::printf("%8d %12.2f %12.2f\n", threads,
+                    Run<ConcurrentHashMap<int, int>>(threads, find_percent, keys),
+                    Run<LockFreeHashMap<int, int>>(threads, find_percent, keys));
+    }
+}
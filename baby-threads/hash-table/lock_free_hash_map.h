@@ -0,0 +1,479 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+// Lock-free hash map with the interface of ConcurrentHashMap, built as a
+// split-ordered list (Shalev, Shavit). All elements are kept in one lock-free
+// list sorted by bit-reversed hash, and every bucket points to a dummy node of
+// the list. So doubling the number of buckets moves nothing: each new bucket is
+// set up by the first operation that needs it, splitting its parent bucket.
+//
+// Erased nodes are freed with epoch-based reclamation once no operation can
+// reach them. The reference returned by At stays valid until the key is erased.
+template <class K, class V, class Hash = std::hash<K>>
+class LockFreeHashMap {
+public:
+    LockFreeHashMap(const Hash& hasher = Hash()) : LockFreeHashMap(kUndefinedSize, hasher) {
+    }
+
+    explicit LockFreeHashMap(int expected_size, const Hash& hasher = Hash())
+        : LockFreeHashMap(expected_size, kDefaultConcurrencyLevel, hasher) {
+    }
+
+    LockFreeHashMap(int expected_size, int expected_threads_count, const Hash& hasher = Hash())
+        : hasher_(hasher) {
+        bucket_count_ = std::bit_ceil(static_cast<size_t>(std::max(1, expected_size)));
+        auto& first = GetSlot(0);
+        first.claimed = true;
+        first.head = &first.dummy;
+
+        // Each running operation takes a guard slot. These are enough for the
+        // expected threads, more are added if needed.
+        size_t threads = std::max(expected_threads_count, 1);
+        threads = std::max<size_t>(threads, std::thread::hardware_concurrency());
+        slot_count_ = std::bit_ceil(2 * threads);
+        slots_ = std::make_unique<GuardSlot[]>(slot_count_);
+    }
+
+    LockFreeHashMap(const LockFreeHashMap&) = delete;
+    LockFreeHashMap& operator=(const LockFreeHashMap&) = delete;
+
+    bool Insert(const K& key, const V& value) {
+        Guard guard(this);
+        auto hash = GetHash(key);
+        auto head = GetBucketHead(hash);
+
+        // Counted in advance, so that an Erase right after linking the node
+        // can't take the size below zero.
+        auto size = ++size_;
+        DataNode* node = nullptr;
+        while (true) {
+            Node* pred;
+            Node* curr;
+            if (Search(head, DataOrder(hash), &key, &pred, &curr)) {
+                --size_;
+                delete node;
+                return false;
+            }
+            if (!node) {
+                node = new DataNode(DataOrder(hash), key, value);
+            }
+            node->next = ToWord(curr);
+            auto expected = ToWord(curr);
+            if (pred->next.compare_exchange_strong(expected, ToWord(node))) {
+                break;
+            }
+        }
+
+        // Growing is just doubling the bucket count, buckets are split lazily.
+        auto buckets = bucket_count_.load();
+        if (size > buckets * kMaxLoadFactor && buckets < kMaxBuckets) {
+            bucket_count_.compare_exchange_strong(buckets, buckets * 2);
+        }
+        return true;
+    }
+
+    bool Erase(const K& key) {
+        Guard guard(this);
+        auto hash = GetHash(key);
+        auto head = GetBucketHead(hash);
+
+        while (true) {
+            Node* pred;
+            Node* curr;
+            if (!Search(head, DataOrder(hash), &key, &pred, &curr)) {
+                return false;
+            }
+
+            // Marking the node erases it logically, then it's unlinked.
+            auto next = curr->next.load();
+            if (IsMarked(next) || !curr->next.compare_exchange_strong(next, next | kMark)) {
+                continue;
+            }
+            --size_;
+
+            auto expected = ToWord(curr);
+            if (pred->next.compare_exchange_strong(expected, next)) {
+                Retire(static_cast<DataNode*>(curr));
+            } else {
+                Search(head, DataOrder(hash), &key, &pred, &curr);
+            }
+            return true;
+        }
+    }
+
+    // Erases the elements present when Clear starts.
+    void Clear() {
+        Guard guard(this);
+        auto head = GetSlot(0).head.load();
+
+        for (auto curr = ToNode(head->next.load()); curr; curr = ToNode(curr->next.load())) {
+            auto next = curr->next.load();
+            if (IsData(curr) && !IsMarked(next) &&
+                curr->next.compare_exchange_strong(next, next | kMark)) {
+                --size_;
+            }
+        }
+
+        // Unlinks all marked nodes on the way to the end of the list.
+        Node* pred;
+        Node* curr;
+        Search(head, UINT64_MAX, nullptr, &pred, &curr);
+    }
+
+    std::pair<bool, V> Find(const K& key) const {
+        Guard guard(this);
+        auto hash = GetHash(key);
+
+        Node* pred;
+        Node* curr;
+        if (!Search(GetBucketHead(hash), DataOrder(hash), &key, &pred, &curr)) {
+            return std::make_pair(false, V{});
+        }
+        return std::make_pair(true, static_cast<DataNode*>(curr)->value);
+    }
+
+    const V& At(const K& key) const {
+        Guard guard(this);
+        auto hash = GetHash(key);
+
+        Node* pred;
+        Node* curr;
+        if (!Search(GetBucketHead(hash), DataOrder(hash), &key, &pred, &curr)) {
+            throw std::out_of_range("");
+        }
+        return static_cast<DataNode*>(curr)->value;
+    }
+
+    size_t Size() const {
+        return size_;
+    }
+
+    ~LockFreeHashMap() {
+        for (auto node = GetSlot(0).head.load(); node;) {
+            auto next = ToNode(node->next.load());
+            if (IsData(node)) {
+                delete static_cast<DataNode*>(node);
+            } else if (node != &GetSlot(Reverse(node->order)).dummy) {
+                delete node;
+            }
+            node = next;
+        }
+        for (auto node = retired_.load(); node;) {
+            auto next = node->retired_next;
+            delete node;
+            node = next;
+        }
+        for (auto& segment : segments_) {
+            delete[] segment.load();
+        }
+        for (auto slot = extra_slots_.load(); slot;) {
+            delete std::exchange(slot, slot->next);
+        }
+    }
+
+    static const int kDefaultConcurrencyLevel;
+    static const int kUndefinedSize;
+
+private:
+    static constexpr size_t kMaxLoadFactor = 1;
+    static constexpr size_t kSegments = 64;
+    static constexpr size_t kMaxBuckets = size_t{1} << (kSegments - 2);
+    static constexpr size_t kReclaimPeriod = 64;
+
+    // The lowest bit of a next pointer marks its node as erased.
+    static constexpr uintptr_t kMark = 1;
+
+    struct Node {
+        // Bit-reversed hash, odd for data nodes and even for dummy ones.
+        uint64_t order = 0;
+        std::atomic<uintptr_t> next = 0;
+    };
+
+    struct DataNode : Node {
+        DataNode(uint64_t order, const K& key, const V& value) : key(key), value(value) {
+            this->order = order;
+        }
+
+        const K key;
+        const V value;
+
+        DataNode* retired_next = nullptr;
+        uint64_t retire_epoch = 0;
+    };
+
+    // Twice the reclamation epoch a running operation started in plus one, or 0.
+    // |next| links the extra slots, it's set before a slot is published.
+    struct alignas(64) GuardSlot {
+        std::atomic<uint64_t> state = 0;
+        GuardSlot* next = nullptr;
+    };
+
+    // Occupies a free slot for the current operation. Threads start looking for
+    // it at different slots, so usually the first one is free. If all of them
+    // are taken, an extra slot is used or added, so an operation never waits.
+    class Guard {
+    public:
+        explicit Guard(const LockFreeHashMap* map) {
+            static thread_local size_t start =
+                std::hash<std::thread::id>{}(std::this_thread::get_id());
+            auto state = map->epoch_.load() * 2 + 1;
+            for (size_t i = 0; i < map->slot_count_; ++i) {
+                if (TryTake(&map->slots_[(start + i) & (map->slot_count_ - 1)], state)) {
+                    return;
+                }
+            }
+            for (auto slot = map->extra_slots_.load(); slot; slot = slot->next) {
+                if (TryTake(slot, state)) {
+                    return;
+                }
+            }
+
+            slot_ = new GuardSlot;
+            slot_->state = state;
+            slot_->next = map->extra_slots_.load();
+            while (!map->extra_slots_.compare_exchange_weak(slot_->next, slot_)) {
+            }
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        ~Guard() {
+            slot_->state.store(0, std::memory_order_release);
+        }
+
+    private:
+        bool TryTake(GuardSlot* slot, uint64_t state) {
+            uint64_t expected = 0;
+            if (slot->state.load() || !slot->state.compare_exchange_strong(expected, state)) {
+                return false;
+            }
+            slot_ = slot;
+            return true;
+        }
+
+        GuardSlot* slot_;
+    };
+
+    static Node* ToNode(uintptr_t word) {
+        return reinterpret_cast<Node*>(word & ~kMark);
+    }
+
+    static uintptr_t ToWord(Node* node) {
+        return reinterpret_cast<uintptr_t>(node);
+    }
+
+    static bool IsMarked(uintptr_t word) {
+        return word & kMark;
+    }
+
+    static bool IsData(const Node* node) {
+        return node->order & 1;
+    }
+
+    static uint64_t Reverse(uint64_t x) {
+        x = ((x >> 1) & 0x5555555555555555ull) | ((x & 0x5555555555555555ull) << 1);
+        x = ((x >> 2) & 0x3333333333333333ull) | ((x & 0x3333333333333333ull) << 2);
+        x = ((x >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((x & 0x0F0F0F0F0F0F0F0Full) << 4);
+        return __builtin_bswap64(x);
+    }
+
+    // Dummy nodes of a bucket go before the nodes of its keys.
+    static uint64_t DummyOrder(size_t bucket) {
+        return Reverse(bucket);
+    }
+
+    static uint64_t DataOrder(uint64_t hash) {
+        return Reverse(hash) | 1;
+    }
+
+    // Buckets take the lowest bits of the hash, so it's mixed first.
+    uint64_t GetHash(const K& key) const {
+        uint64_t hash = hasher_(key);
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdull;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ull;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    // |head| is the dummy node of the bucket once it's in the list. It's usually
+    // |dummy| itself, which only the thread that claims it may link.
+    struct Bucket {
+        std::atomic<Node*> head = nullptr;
+        std::atomic_bool claimed = false;
+        Node dummy;
+    };
+
+    // Segment i > 0 holds buckets [2^(i - 1), 2^i), segment 0 holds bucket 0.
+    // Segments are allocated on first use and never move.
+    Bucket& GetSlot(size_t bucket) const {
+        auto segment = std::bit_width(bucket);
+        auto first = segment == 0 ? 0 : size_t{1} << (segment - 1);
+
+        auto table = segments_[segment].load();
+        if (!table) {
+            auto fresh = new Bucket[std::max<size_t>(first, 1)];
+            if (segments_[segment].compare_exchange_strong(table, fresh)) {
+                table = fresh;
+            } else {
+                delete[] fresh;
+            }
+        }
+        return table[bucket - first];
+    }
+
+    Node* GetBucketHead(uint64_t hash) const {
+        return GetBucket(hash & (bucket_count_.load() - 1));
+    }
+
+    Node* GetBucket(size_t bucket) const {
+        auto& slot = GetSlot(bucket);
+        if (auto head = slot.head.load()) {
+            return head;
+        }
+
+        // A bucket splits its parent, the bucket without the highest bit. Threads
+        // that come while the dummy node is claimed race with a node of their own.
+        auto parent = GetBucket(bucket & ~std::bit_floor(bucket));
+        auto dummy = &slot.dummy;
+        bool claimed = false;
+        if (!slot.claimed.compare_exchange_strong(claimed, true)) {
+            dummy = new Node;
+        }
+        dummy->order = DummyOrder(bucket);
+
+        Node* head = dummy;
+        while (true) {
+            Node* pred;
+            Node* curr;
+            if (Search(parent, dummy->order, nullptr, &pred, &curr)) {
+                if (dummy != &slot.dummy) {
+                    delete dummy;
+                }
+                head = curr;
+                break;
+            }
+            dummy->next = ToWord(curr);
+            auto expected = ToWord(curr);
+            if (pred->next.compare_exchange_strong(expected, ToWord(dummy))) {
+                break;
+            }
+        }
+        slot.head = head;
+        return head;
+    }
+
+    // Looks for the node of |key| (or the dummy node if |key| is null) with the
+    // given |order| after |head|. Returns whether it's found in |*curr|; otherwise
+    // |*curr| is the node to insert before. Erased nodes on the way are unlinked.
+    bool Search(Node* head, uint64_t order, const K* key, Node** pred, Node** curr) const {
+    retry:
+        *pred = head;
+        *curr = ToNode(head->next.load());
+        while (*curr) {
+            auto next = (*curr)->next.load();
+            if (IsMarked(next)) {
+                auto expected = ToWord(*curr);
+                if (!(*pred)->next.compare_exchange_strong(expected, next & ~kMark)) {
+                    goto retry;
+                }
+                Retire(static_cast<DataNode*>(*curr));
+                *curr = ToNode(next);
+                continue;
+            }
+
+            if ((*curr)->order > order) {
+                return false;
+            }
+            if ((*curr)->order == order &&
+                (key ? IsData(*curr) && static_cast<DataNode*>(*curr)->key == *key
+                     : !IsData(*curr))) {
+                return true;
+            }
+            *pred = *curr;
+            *curr = ToNode(next);
+        }
+        return false;
+    }
+
+    // Only data nodes are erased, dummy ones stay until the map is destroyed.
+    void Retire(DataNode* node) const {
+        node->retire_epoch = epoch_.load();
+        auto head = retired_.load();
+        do {
+            node->retired_next = head;
+        } while (!retired_.compare_exchange_weak(head, node));
+
+        if (++retired_count_ % kReclaimPeriod == 0) {
+            Reclaim();
+        }
+    }
+
+    // Frees nodes retired before every running operation started. An operation
+    // that started after a node was unlinked can't reach it, and one that takes
+    // a slot after the scan below starts after that too.
+    void Reclaim() const {
+        std::unique_lock lock(reclaim_mutex_, std::try_to_lock);
+        if (!lock) {
+            return;
+        }
+
+        auto min_epoch = epoch_.fetch_add(1) + 1;
+        auto scan = [&](const GuardSlot& slot) {
+            if (auto state = slot.state.load()) {
+                min_epoch = std::min(min_epoch, state / 2);
+            }
+        };
+        for (size_t i = 0; i < slot_count_; ++i) {
+            scan(slots_[i]);
+        }
+        for (auto slot = extra_slots_.load(); slot; slot = slot->next) {
+            scan(*slot);
+        }
+
+        for (auto node = retired_.exchange(nullptr); node;) {
+            auto next = node->retired_next;
+            if (node->retire_epoch < min_epoch) {
+                delete node;
+            } else {
+                auto head = retired_.load();
+                do {
+                    node->retired_next = head;
+                } while (!retired_.compare_exchange_weak(head, node));
+            }
+            node = next;
+        }
+    }
+
+    Hash hasher_;
+    std::atomic<size_t> size_ = 0;
+    std::atomic<size_t> bucket_count_;
+    mutable std::atomic<Bucket*> segments_[kSegments] = {};
+
+    size_t slot_count_;
+    std::unique_ptr<GuardSlot[]> slots_;
+    mutable std::atomic<GuardSlot*> extra_slots_ = nullptr;  // never removed
+    mutable std::atomic<uint64_t> epoch_ = 0;
+    mutable std::atomic<DataNode*> retired_ = nullptr;
+    mutable std::atomic<size_t> retired_count_ = 0;
+    mutable std::mutex reclaim_mutex_;
+};
+
+template <class K, class V, class Hash>
+const int LockFreeHashMap<K, V, Hash>::kDefaultConcurrencyLevel = 8;
+
+template <class K, class V, class Hash>
+const int LockFreeHashMap<K, V, Hash>::kUndefinedSize = -1;
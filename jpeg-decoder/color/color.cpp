@@ -0,0 +1,203 @@
+#include "color.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include "color_kernel.h"
+
+#if defined(__x86_64__)
+#include <emmintrin.h>
+
+// Defined in color_avx2.cpp, which is compiled with AVX2 enabled.
+void YCbCrToRgbRowAvx2(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *rgb,
+                       size_t width);
+#endif
+
+namespace {
+
+#if defined(__x86_64__)
+
+// Converts 8 pixels of 16-bit samples, Cb and Cr already centered at 0.
+void Convert8(__m128i y, __m128i cb, __m128i cr, __m128i *red, __m128i *green, __m128i *blue) {
+    auto low = _mm_unpacklo_epi16(cb, cr);
+    auto high = _mm_unpackhi_epi16(cb, cr);
+    auto half = _mm_set1_epi32(color_kernel::kHalf);
+    auto delta = [&](int32_t factors) {
+        auto pair = _mm_set1_epi32(factors);
+        auto lo =
+            _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(low, pair), half), color_kernel::kBits);
+        auto hi =
+            _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(high, pair), half), color_kernel::kBits);
+        return _mm_packs_epi32(lo, hi);
+    };
+    *red = _mm_add_epi16(y, delta(color_kernel::PackPair(0, color_kernel::kCrToR)));
+    *green = _mm_add_epi16(
+        y, delta(color_kernel::PackPair(color_kernel::kCbToG, color_kernel::kCrToG)));
+    *blue = _mm_add_epi16(y, delta(color_kernel::PackPair(color_kernel::kCbToB, 0)));
+}
+
+void YCbCrToRgbRowSse2(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *rgb,
+                       size_t width) {
+    constexpr size_t kBlock = 16;
+    alignas(16) uint8_t red[kBlock], green[kBlock], blue[kBlock];
+    auto zero = _mm_setzero_si128();
+    auto center = _mm_set1_epi16(128);
+
+    size_t i = 0;
+    for (; i + kBlock <= width; i += kBlock) {
+        auto y8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + i));
+        auto cb8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(cb + i));
+        auto cr8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(cr + i));
+
+        __m128i r[2], g[2], b[2];
+        Convert8(_mm_unpacklo_epi8(y8, zero), _mm_sub_epi16(_mm_unpacklo_epi8(cb8, zero), center),
+                 _mm_sub_epi16(_mm_unpacklo_epi8(cr8, zero), center), &r[0], &g[0], &b[0]);
+        Convert8(_mm_unpackhi_epi8(y8, zero), _mm_sub_epi16(_mm_unpackhi_epi8(cb8, zero), center),
+                 _mm_sub_epi16(_mm_unpackhi_epi8(cr8, zero), center), &r[1], &g[1], &b[1]);
+
+        // Saturating packs clamp to [0, 255].
+        _mm_store_si128(reinterpret_cast<__m128i *>(red), _mm_packus_epi16(r[0], r[1]));
+        _mm_store_si128(reinterpret_cast<__m128i *>(green), _mm_packus_epi16(g[0], g[1]));
+        _mm_store_si128(reinterpret_cast<__m128i *>(blue), _mm_packus_epi16(b[0], b[1]));
+        color_kernel::Interleave(red, green, blue, rgb + 3 * i, kBlock);
+    }
+    color_kernel::ConvertScalar(y + i, cb + i, cr + i, rgb + 3 * i, width - i);
+}
+
+#endif
+
+// Doubles the width of a chroma row. |out| gets 2 * |width| samples.
+void UpsampleH2(const uint8_t *in, size_t width, uint8_t *out, Upsampling upsampling) {
+    if (upsampling == Upsampling::SIMPLE || width == 1) {
+        for (size_t i = 0; i < width; ++i) {
+            out[2 * i] = out[2 * i + 1] = in[i];
+        }
+        return;
+    }
+
+    out[0] = in[0];
+    out[1] = (in[0] * 3 + in[1] + 2) >> 2;
+    for (size_t i = 1; i + 1 < width; ++i) {
+        out[2 * i] = (in[i] * 3 + in[i - 1] + 1) >> 2;
+        out[2 * i + 1] = (in[i] * 3 + in[i + 1] + 2) >> 2;
+    }
+    out[2 * width - 2] = (in[width - 1] * 3 + in[width - 2] + 1) >> 2;
+    out[2 * width - 1] = in[width - 1];
+}
+
+// Doubles the width of the chroma row |near| using |far|, the row on the other
+// side of the output row, for the vertical part of the filter.
+void UpsampleH2V2Fancy(const uint8_t *near, const uint8_t *far, size_t width,
+                       std::vector<int> *sums, uint8_t *out) {
+    sums->resize(width);
+    auto &sum = *sums;
+    for (size_t i = 0; i < width; ++i) {
+        sum[i] = near[i] * 3 + far[i];
+    }
+
+    if (width == 1) {
+        out[0] = (sum[0] * 4 + 8) >> 4;
+        out[1] = (sum[0] * 4 + 7) >> 4;
+        return;
+    }
+    out[0] = (sum[0] * 4 + 8) >> 4;
+    out[1] = (sum[0] * 3 + sum[1] + 7) >> 4;
+    for (size_t i = 1; i + 1 < width; ++i) {
+        out[2 * i] = (sum[i] * 3 + sum[i - 1] + 8) >> 4;
+        out[2 * i + 1] = (sum[i] * 3 + sum[i + 1] + 7) >> 4;
+    }
+    out[2 * width - 2] = (sum[width - 1] * 3 + sum[width - 2] + 8) >> 4;
+    out[2 * width - 1] = (sum[width - 1] * 4 + 7) >> 4;
+}
+
+const uint8_t *Row(PlaneView plane, size_t row) {
+    return plane.data + row * plane.stride;
+}
+
+}  // namespace
+
+bool IsSupported(ColorKernel kernel) {
+    switch (kernel) {
+        case ColorKernel::SCALAR:
+            return true;
+#if defined(__x86_64__)
+        case ColorKernel::SSE2:
+            return true;
+        case ColorKernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+ColorKernel GetBestColorKernel() {
+    static const auto kBest = [] {
+        for (auto kernel : {ColorKernel::AVX2, ColorKernel::SSE2}) {
+            if (IsSupported(kernel)) {
+                return kernel;
+            }
+        }
+        return ColorKernel::SCALAR;
+    }();
+    return kBest;
+}
+
+void YCbCrToRgbRow(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *rgb,
+                   size_t width, ColorKernel kernel) {
+    if (!IsSupported(kernel)) {
+        throw std::invalid_argument("bad");
+    }
+    switch (kernel) {
+#if defined(__x86_64__)
+        case ColorKernel::SSE2:
+            YCbCrToRgbRowSse2(y, cb, cr, rgb, width);
+            return;
+        case ColorKernel::AVX2:
+            YCbCrToRgbRowAvx2(y, cb, cr, rgb, width);
+            return;
+#endif
+        default:
+            color_kernel::ConvertScalar(y, cb, cr, rgb, width);
+    }
+}
+
+void ConvertRows(ChromaSubsampling subsampling, Upsampling upsampling, PlaneView y, PlaneView cb,
+                 PlaneView cr, size_t width, size_t first_row, size_t count, uint8_t *rgb,
+                 size_t rgb_stride, ColorKernel kernel) {
+    auto horizontal = subsampling == ChromaSubsampling::H1V1 ? 1 : 2;
+    auto vertical = subsampling == ChromaSubsampling::H2V2 ? 2 : 1;
+    auto chroma_width = (width + horizontal - 1) / horizontal;
+    auto chroma_rows = (first_row + count + vertical - 1) / vertical;
+    if (first_row + count > y.rows || chroma_rows > cb.rows || chroma_rows > cr.rows) {
+        throw std::invalid_argument("bad");
+    }
+
+    // Upsampled rows are a bit wider than the image for odd widths.
+    std::vector<uint8_t> blue(chroma_width * horizontal);
+    std::vector<uint8_t> red(chroma_width * horizontal);
+    std::vector<int> sums;
+
+    for (size_t row = first_row; row < first_row + count; ++row) {
+        auto chroma_row = row / vertical;
+        const uint8_t *cb_row = Row(cb, chroma_row);
+        const uint8_t *cr_row = Row(cr, chroma_row);
+
+        if (subsampling == ChromaSubsampling::H2V2 && upsampling == Upsampling::FANCY) {
+            // Even rows lean on the chroma row above, odd rows on the one below.
+            auto far_row = row % 2 == 0 ? (chroma_row == 0 ? 0 : chroma_row - 1)
+                                        : std::min(chroma_row + 1, std::min(cb.rows, cr.rows) - 1);
+            UpsampleH2V2Fancy(cb_row, Row(cb, far_row), chroma_width, &sums, blue.data());
+            UpsampleH2V2Fancy(cr_row, Row(cr, far_row), chroma_width, &sums, red.data());
+            cb_row = blue.data();
+            cr_row = red.data();
+        } else if (horizontal == 2) {
+            UpsampleH2(cb_row, chroma_width, blue.data(), upsampling);
+            UpsampleH2(cr_row, chroma_width, red.data(), upsampling);
+            cb_row = blue.data();
+            cr_row = red.data();
+        }
+
+        YCbCrToRgbRow(Row(y, row), cb_row, cr_row, rgb + (row - first_row) * rgb_stride, width,
+                      kernel);
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Color stage of the decoder: chroma upsampling and YCbCr to RGB conversion of
+// level-shifted 8-bit samples. All kernels give bit-exact results.
+enum class ColorKernel {
+    SCALAR,
+    SSE2,
+    AVX2,
+};
+
+// The fastest kernel the CPU supports.
+ColorKernel GetBestColorKernel();
+
+bool IsSupported(ColorKernel kernel);
+
+// Chroma resolution relative to luma, horizontally and vertically.
+enum class ChromaSubsampling {
+    H1V1,  // 4:4:4
+    H2V1,  // 4:2:2
+    H2V2,  // 4:2:0
+};
+
+enum class Upsampling {
+    SIMPLE,  // replicates chroma samples
+    FANCY,   // triangle filter, as in libjpeg
+};
+
+// Rows of an 8-bit image component.
+struct PlaneView {
+    const uint8_t *data = nullptr;
+    size_t stride = 0;
+    size_t rows = 0;
+};
+
+// Converts |width| pixels of full resolution components into interleaved RGB.
+void YCbCrToRgbRow(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *rgb,
+                   size_t width, ColorKernel kernel = GetBestColorKernel());
+
+// Converts rows [first_row, first_row + count) of a |width| pixels wide image, e.g.
+// an MCU row, into interleaved RGB rows |rgb_stride| apart. Chroma planes are
+// subsampled as given by |subsampling|; row numbers are relative to the first
+// rows of the planes. Fancy upsampling takes the neighbouring chroma rows as
+// context, clamped to the rows the planes have.
+void ConvertRows(ChromaSubsampling subsampling, Upsampling upsampling, PlaneView y, PlaneView cb,
+                 PlaneView cr, size_t width, size_t first_row, size_t count, uint8_t *rgb,
+                 size_t rgb_stride, ColorKernel kernel = GetBestColorKernel());
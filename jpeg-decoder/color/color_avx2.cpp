@@ -0,0 +1,62 @@
+// Only the AVX2 kernel lives here, as the file is compiled with -mavx2.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#include <cstddef>
+#include <cstdint>
+#include "color_kernel.h"
+
+namespace {
+
+// Converts 16 pixels of 16-bit samples, Cb and Cr already centered at 0. Unpacks
+// and packs work within 128-bit lanes, so the pixel order is kept.
+void Convert16(__m256i y, __m256i cb, __m256i cr, __m256i *red, __m256i *green, __m256i *blue) {
+    auto low = _mm256_unpacklo_epi16(cb, cr);
+    auto high = _mm256_unpackhi_epi16(cb, cr);
+    auto half = _mm256_set1_epi32(color_kernel::kHalf);
+    auto delta = [&](int32_t factors) {
+        auto pair = _mm256_set1_epi32(factors);
+        auto lo = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(low, pair), half),
+                                    color_kernel::kBits);
+        auto hi = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(high, pair), half),
+                                    color_kernel::kBits);
+        return _mm256_packs_epi32(lo, hi);
+    };
+    *red = _mm256_add_epi16(y, delta(color_kernel::PackPair(0, color_kernel::kCrToR)));
+    *green = _mm256_add_epi16(
+        y, delta(color_kernel::PackPair(color_kernel::kCbToG, color_kernel::kCrToG)));
+    *blue = _mm256_add_epi16(y, delta(color_kernel::PackPair(color_kernel::kCbToB, 0)));
+}
+
+}  // namespace
+
+void YCbCrToRgbRowAvx2(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *rgb,
+                       size_t width) {
+    constexpr size_t kBlock = color_kernel::kMaxBlock;
+    alignas(32) uint8_t red[kBlock], green[kBlock], blue[kBlock];
+    auto zero = _mm256_setzero_si256();
+    auto center = _mm256_set1_epi16(128);
+
+    size_t i = 0;
+    for (; i + kBlock <= width; i += kBlock) {
+        auto y8 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + i));
+        auto cb8 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cb + i));
+        auto cr8 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cr + i));
+
+        __m256i r[2], g[2], b[2];
+        Convert16(_mm256_unpacklo_epi8(y8, zero),
+                  _mm256_sub_epi16(_mm256_unpacklo_epi8(cb8, zero), center),
+                  _mm256_sub_epi16(_mm256_unpacklo_epi8(cr8, zero), center), &r[0], &g[0], &b[0]);
+        Convert16(_mm256_unpackhi_epi8(y8, zero),
+                  _mm256_sub_epi16(_mm256_unpackhi_epi8(cb8, zero), center),
+                  _mm256_sub_epi16(_mm256_unpackhi_epi8(cr8, zero), center), &r[1], &g[1], &b[1]);
+
+        // Saturating packs clamp to [0, 255].
+        _mm256_store_si256(reinterpret_cast<__m256i *>(red), _mm256_packus_epi16(r[0], r[1]));
+        _mm256_store_si256(reinterpret_cast<__m256i *>(green), _mm256_packus_epi16(g[0], g[1]));
+        _mm256_store_si256(reinterpret_cast<__m256i *>(blue), _mm256_packus_epi16(b[0], b[1]));
+        color_kernel::Interleave(red, green, blue, rgb + 3 * i, kBlock);
+    }
+    color_kernel::ConvertScalar(y + i, cb + i, cr + i, rgb + 3 * i, width - i);
+}
+
+#endif
@@ -0,0 +1,99 @@
+// Megapixels per second of the color stage. Not part of a build target, from
+// this directory:
+//   g++ -std=c++20 -O2 -mavx2 -c color_avx2.cpp
+//   g++ -std=c++20 -O2 color_benchmark.cpp color.cpp color_avx2.o
+//   ./a.out [width] [height]
+//
+// Converts a random image with every kernel, first from full resolution chroma
+// with YCbCrToRgbRow, then with ConvertRows for every subsampling and fancy
+// upsampling, 16 rows at a time like an MCU row of 4:2:0.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "color.h"
+
+namespace {
+
+constexpr std::chrono::milliseconds kDuration{500};
+constexpr size_t kBand = 16;
+
+// Megapixels per second of |pass|, which converts |pixels| pixels.
+double Measure(size_t pixels, const std::function<void()> &pass) {
+    size_t passes = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed{};
+    while (elapsed < kDuration) {
+        pass();
+        ++passes;
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    return passes * pixels / elapsed.count() / 1e6;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    auto width = argc > 1 ? std::atoi(argv[1]) : 1920;
+    auto height = argc > 2 ? std::atoi(argv[2]) : 1080;
+    if (width < 1 || height < 1) {
+        std::fprintf(stderr, "usage: %s [width] [height]\n", argv[0]);
+        return 1;
+    }
+
+    size_t pixels = static_cast<size_t>(width) * height;
+    std::mt19937 rng(1);
+    std::vector<uint8_t> y(pixels);
+    std::vector<uint8_t> cb(pixels);
+    std::vector<uint8_t> cr(pixels);
+    for (auto *plane : {&y, &cb, &cr}) {
+        for (auto &sample : *plane) {
+            sample = rng();
+        }
+    }
+    std::vector<uint8_t> rgb(3 * pixels);
+
+    std::printf("%dx%d, MP/s\n", width, height);
+    std::printf("%-8s %10s %10s %10s %10s\n", "kernel", "row", "4:4:4", "4:2:2", "4:2:0");
+    for (auto [kernel, name] : {std::pair{ColorKernel::SCALAR, "scalar"},
+                                std::pair{ColorKernel::SSE2, "sse2"},
+                                std::pair{ColorKernel::AVX2, "avx2"}}) {
+        if (!IsSupported(kernel)) {
+            continue;
+        }
+        std::printf("%-8s %10.1f", name, Measure(pixels, [&] {
+                        for (int row = 0; row < height; ++row) {
+                            auto offset = static_cast<size_t>(row) * width;
+                            YCbCrToRgbRow(y.data() + offset, cb.data() + offset,
+                                          cr.data() + offset, rgb.data() + 3 * offset, width,
+                                          kernel);
+                        }
+                    }));
+
+        for (auto subsampling :
+             {ChromaSubsampling::H1V1, ChromaSubsampling::H2V1, ChromaSubsampling::H2V2}) {
+            size_t horizontal = subsampling == ChromaSubsampling::H1V1 ? 1 : 2;
+            size_t vertical = subsampling == ChromaSubsampling::H2V2 ? 2 : 1;
+            auto chroma_width = (width + horizontal - 1) / horizontal;
+            auto chroma_height = (height + vertical - 1) / vertical;
+            PlaneView luma{y.data(), static_cast<size_t>(width), static_cast<size_t>(height)};
+            PlaneView blue{cb.data(), chroma_width, chroma_height};
+            PlaneView red{cr.data(), chroma_width, chroma_height};
+            std::printf(" %10.1f", Measure(pixels, [&] {
+                            for (size_t row = 0; row < luma.rows; row += kBand) {
+                                auto count = std::min(kBand, luma.rows - row);
+                                ConvertRows(subsampling, Upsampling::FANCY, luma, blue, red,
+                                            width, row, count, rgb.data() + 3 * row * width,
+                                            3 * width, kernel);
+                            }
+                        }));
+        }
+        std::printf("\n");
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// The fixed point conversion shared by the color kernels. SIMD kernels compute
+// the same sums with 16-bit multiplications into 32 bits.
+namespace color_kernel {
+
+constexpr int kBits = 14;
+constexpr int32_t kHalf = 1 << (kBits - 1);
+
+// JFIF factors scaled by 2^kBits.
+constexpr int16_t kCrToR = 22970;   // 1.402
+constexpr int16_t kCbToG = -5638;   // -0.344136
+constexpr int16_t kCrToG = -11700;  // -0.714136
+constexpr int16_t kCbToB = 29032;   // 1.772
+
+// Both factors of a _mm_madd_epi16 lane pair: |low| multiplies Cb, |high| Cr.
+constexpr int32_t PackPair(int16_t low, int16_t high) {
+    return static_cast<int32_t>(static_cast<uint16_t>(low) |
+                                static_cast<uint32_t>(static_cast<uint16_t>(high)) << 16);
+}
+
+inline uint8_t Clamp(int32_t value) {
+    return std::clamp(value, 0, 255);
+}
+
+inline void ConvertScalar(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *rgb,
+                          size_t width) {
+    for (size_t i = 0; i < width; ++i) {
+        int32_t blue = cb[i] - 128;
+        int32_t red = cr[i] - 128;
+        rgb[3 * i] = Clamp(y[i] + ((kCrToR * red + kHalf) >> kBits));
+        rgb[3 * i + 1] = Clamp(y[i] + ((kCbToG * blue + kCrToG * red + kHalf) >> kBits));
+        rgb[3 * i + 2] = Clamp(y[i] + ((kCbToB * blue + kHalf) >> kBits));
+    }
+}
+
+// SIMD kernels compute separate R, G and B rows of this many pixels at most and
+// interleave them here.
+constexpr size_t kMaxBlock = 32;
+
+inline void Interleave(const uint8_t *red, const uint8_t *green, const uint8_t *blue, uint8_t *rgb,
+                       size_t width) {
+    for (size_t i = 0; i < width; ++i) {
+        rgb[3 * i] = red[i];
+        rgb[3 * i + 1] = green[i];
+        rgb[3 * i + 2] = blue[i];
+    }
+}
+
+}  // namespace color_kernel
@@ -0,0 +1,146 @@
+// Color kernels and ConvertRows. Not part of a build target, from this directory:
+//   g++ -std=c++20 -O2 -mavx2 -c color_avx2.cpp
+//   g++ -std=c++20 -O2 color_test.cpp color.cpp color_avx2.o
+//
+// Every kernel has to match color_kernel::ConvertScalar bit for bit over all Cb
+// and Cr pairs, ConvertRows has to give the same image with every kernel for odd
+// sizes, and converting an image in bands has to match converting it at once.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "color.h"
+#include "color_kernel.h"
+
+namespace {
+
+constexpr ColorKernel kKernels[] = {ColorKernel::SCALAR, ColorKernel::SSE2, ColorKernel::AVX2};
+constexpr ChromaSubsampling kSubsamplings[] = {ChromaSubsampling::H1V1, ChromaSubsampling::H2V1,
+                                               ChromaSubsampling::H2V2};
+constexpr Upsampling kUpsamplings[] = {Upsampling::SIMPLE, Upsampling::FANCY};
+
+void Check(bool condition, const char *what) {
+    if (!condition) {
+        std::fprintf(stderr, "failed: %s\n", what);
+        std::exit(1);
+    }
+}
+
+// Random planes of a |width| by |height| image.
+struct Image {
+    Image(ChromaSubsampling subsampling, size_t columns, size_t rows, std::mt19937 *rng)
+        : width(columns), height(rows) {
+        auto horizontal = subsampling == ChromaSubsampling::H1V1 ? 1 : 2;
+        auto vertical = subsampling == ChromaSubsampling::H2V2 ? 2 : 1;
+        chroma_width = (width + horizontal - 1) / horizontal;
+        chroma_height = (height + vertical - 1) / vertical;
+        for (auto [plane, size] : {std::pair{&y, width * height},
+                                   std::pair{&cb, chroma_width * chroma_height},
+                                   std::pair{&cr, chroma_width * chroma_height}}) {
+            plane->resize(size);
+            for (auto &sample : *plane) {
+                sample = (*rng)();
+            }
+        }
+    }
+
+    // Rows [first_row, first_row + count) converted with |kernel|.
+    std::vector<uint8_t> Convert(ChromaSubsampling subsampling, Upsampling upsampling,
+                                 size_t first_row, size_t count, ColorKernel kernel) const {
+        std::vector<uint8_t> rgb(3 * width * count);
+        ConvertRows(subsampling, upsampling, {y.data(), width, height},
+                    {cb.data(), chroma_width, chroma_height},
+                    {cr.data(), chroma_width, chroma_height}, width, first_row, count, rgb.data(),
+                    3 * width, kernel);
+        return rgb;
+    }
+
+    size_t width;
+    size_t height;
+    size_t chroma_width;
+    size_t chroma_height;
+    std::vector<uint8_t> y;
+    std::vector<uint8_t> cb;
+    std::vector<uint8_t> cr;
+};
+
+void CheckAllChroma() {
+    // Pixel i of a row has Cb i % 256 and Cr i / 256, every row its own Y.
+    constexpr size_t kWidth = 256 * 256;
+    std::vector<uint8_t> y(kWidth);
+    std::vector<uint8_t> cb(kWidth);
+    std::vector<uint8_t> cr(kWidth);
+    for (size_t i = 0; i < kWidth; ++i) {
+        cb[i] = i % 256;
+        cr[i] = i / 256;
+    }
+
+    std::vector<uint8_t> expected(3 * kWidth);
+    std::vector<uint8_t> rgb(3 * kWidth);
+    for (int luma = 0; luma < 256; ++luma) {
+        std::fill(y.begin(), y.end(), luma);
+        color_kernel::ConvertScalar(y.data(), cb.data(), cr.data(), expected.data(), kWidth);
+        for (auto kernel : kKernels) {
+            if (IsSupported(kernel)) {
+                YCbCrToRgbRow(y.data(), cb.data(), cr.data(), rgb.data(), kWidth, kernel);
+                Check(rgb == expected, "kernel matches ConvertScalar");
+            }
+        }
+    }
+}
+
+void CheckOddSizes(std::mt19937 *rng) {
+    for (auto subsampling : kSubsamplings) {
+        for (auto upsampling : kUpsamplings) {
+            for (size_t width = 1; width <= 67; width += 2) {
+                for (size_t height = 1; height <= 9; height += 2) {
+                    Image image(subsampling, width, height, rng);
+                    auto expected =
+                        image.Convert(subsampling, upsampling, 0, height, ColorKernel::SCALAR);
+                    for (auto kernel : kKernels) {
+                        if (IsSupported(kernel)) {
+                            Check(image.Convert(subsampling, upsampling, 0, height, kernel) ==
+                                      expected,
+                                  "kernels agree on odd sizes");
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void CheckBands(std::mt19937 *rng) {
+    for (auto subsampling : kSubsamplings) {
+        for (auto upsampling : kUpsamplings) {
+            Image image(subsampling, 45, 37, rng);
+            auto whole = image.Convert(subsampling, upsampling, 0, image.height,
+                                       GetBestColorKernel());
+            for (size_t band : {1, 2, 3, 8, 16}) {
+                std::vector<uint8_t> banded;
+                for (size_t row = 0; row < image.height; row += band) {
+                    auto count = std::min(band, image.height - row);
+                    auto rgb = image.Convert(subsampling, upsampling, row, count,
+                                             GetBestColorKernel());
+                    banded.insert(banded.end(), rgb.begin(), rgb.end());
+                }
+                Check(banded == whole, "bands match the whole image");
+            }
+        }
+    }
+}
+
+}  // namespace
+
+int main() {
+    std::mt19937 rng(1);
+    CheckAllChroma();
+    CheckOddSizes(&rng);
+    CheckBands(&rng);
+    std::puts("ok");
+}
@@ -0,0 +1,7 @@
+add_library(decoder_color color.cpp color_avx2.cpp)
+
+if (CMAKE_SYSTEM_PROCESSOR MATCHES "x86_64|AMD64")
+    set_source_files_properties(color_avx2.cpp PROPERTIES COMPILE_OPTIONS -mavx2)
+endif()
+
+target_include_directories(decoder_color PUBLIC ${CMAKE_CURRENT_LIST_DIR})
@@ -1,24 +1,112 @@
 #include <fft.h>
 
 #include <fftw3.h>
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <list>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <utility>
+#include "idct.h"
+
+namespace {
+
+// FFTW planner isn't thread-safe, unlike executing plans.
+std::mutex planner_mutex;
+
+// Matrices transformed by one execution of a batch plan.
+constexpr size_t kBatchBlocks = 16;
+
+// Widths whose plans are kept after their last calculator is gone.
+constexpr size_t kCachedWidths = 4;
+
+// In-place plan for |blocks| width by width matrices. It's created for
+// unaligned arrays, so it can be executed on any buffer. Needs planner_mutex.
+fftw_plan MakeBatchPlan(int width, int blocks) {
+    std::vector<double> buffer(width * width * blocks);
+    int sizes[] = {width, width};
+    fftw_r2r_kind kinds[] = {FFTW_REDFT01, FFTW_REDFT01};
+    return fftw_plan_many_r2r(2, sizes, blocks, buffer.data(), nullptr, 1, width * width,
+                              buffer.data(), nullptr, 1, width * width, kinds,
+                              FFTW_ESTIMATE | FFTW_UNALIGNED);
+}
+
+}  // namespace
+
+// Plans for a fixed batch of matrices of one width and for a single one, which
+// takes the rest of a batch.
+class BatchDctCalculator::Plans {
+public:
+    explicit Plans(int width)
+        : batch(MakeBatchPlan(width, kBatchBlocks)), single(MakeBatchPlan(width, 1)) {
+    }
+
+    Plans(const Plans &) = delete;
+    Plans &operator=(const Plans &) = delete;
+
+    ~Plans() {
+        std::lock_guard lock(planner_mutex);
+        fftw_destroy_plan(batch);
+        fftw_destroy_plan(single);
+    }
+
+    const fftw_plan batch;
+    const fftw_plan single;
+};
+
+// The last few widths stay cached, so their plans are made once however many
+// calculators come and go. Calculators hold on to their plans, so evicting a
+// width never destroys plans in use.
+std::shared_ptr<const BatchDctCalculator::Plans> BatchDctCalculator::GetPlans(int width) {
+    static std::list<std::pair<int, std::shared_ptr<const Plans>>> cache;
+
+    std::shared_ptr<const Plans> evicted;
+    std::lock_guard lock(planner_mutex);
+    auto it = std::ranges::find(cache, width, &decltype(cache)::value_type::first);
+    if (it != cache.end()) {
+        cache.splice(cache.begin(), cache, it);
+        return cache.front().second;
+    }
+
+    cache.emplace_front(width, std::make_shared<const Plans>(width));
+    if (cache.size() > kCachedWidths) {
+        // Destroying plans takes the lock, so it's done after unlocking.
+        evicted = std::move(cache.back().second);
+        cache.pop_back();
+    }
+    return cache.front().second;
+}
 
 class DctCalculator::Impl {
 public:
-    Impl(size_t width, std::vector<double> *input, std::vector<double> *output)
+    Impl(size_t width, std::vector<double> *input, std::vector<double> *output,
+         DctBackend backend)
         : length_(input->size() / width), width_(width), input_(input), output_(output) {
         if (input->size() != width * width || output->size() != width * width) {
             throw std::invalid_argument("bad");
         }
+        if (backend == DctBackend::FIXED_POINT) {
+            if (width != 8) {
+                throw std::invalid_argument("bad");
+            }
+            kernel_ = GetBestIdctKernel();
+            return;
+        }
+        std::lock_guard lock(planner_mutex);
         plan_ = fftw_plan_r2r_2d(length_, width_, input_->data(), output_->data(),
                                  fftw_r2r_kind::FFTW_REDFT01, fftw_r2r_kind::FFTW_REDFT01,
                                  FFTW_ESTIMATE);
     };
 
     void Inverse() {
+        if (!plan_) {
+            InverseFixedPoint();
+            return;
+        }
+
         for (int i = 0; i < width_; ++i) {
             for (int j = 0; j < width_; ++j) {
                 auto idx = i * width_ + j;
@@ -38,24 +126,100 @@ public:
         }
     }
 
+    void InverseScaled(size_t scale) {
+        if (scale == 1) {
+            Inverse();
+            return;
+        }
+        if (plan_ || (scale != 2 && scale != 4 && scale != 8)) {
+            throw std::invalid_argument("bad");
+        }
+
+        int32_t block[64];
+        for (int i = 0; i < 64; ++i) {
+            block[i] = std::lround((*input_)[i]);
+        }
+        auto size = 8 / scale;
+        InverseDctScaled(block, size);
+        for (size_t i = 0; i < size * size; ++i) {
+            (*output_)[i] = block[i];
+        }
+    }
+
     ~Impl() {
-        fftw_destroy_plan(plan_);
+        if (plan_) {
+            std::lock_guard lock(planner_mutex);
+            fftw_destroy_plan(plan_);
+        }
     }
 
 private:
+    void InverseFixedPoint() {
+        int32_t block[64];
+        for (int i = 0; i < 64; ++i) {
+            block[i] = std::lround((*input_)[i]);
+        }
+        InverseDct8x8(block, kernel_);
+        for (int i = 0; i < 64; ++i) {
+            (*output_)[i] = block[i];
+        }
+    }
+
     int length_;
     int width_;
     std::vector<double> *input_;
     std::vector<double> *output_;
-    fftw_plan plan_;
+    fftw_plan plan_ = nullptr;
+    IdctKernel kernel_ = IdctKernel::SCALAR;
 };
 
-DctCalculator::DctCalculator(size_t width, std::vector<double> *input, std::vector<double> *output)
-    : impl_(std::make_unique<Impl>(width, input, output)) {
+DctCalculator::DctCalculator(size_t width, std::vector<double> *input, std::vector<double> *output,
+                             DctBackend backend)
+    : impl_(std::make_unique<Impl>(width, input, output, backend)) {
 }
 
 void DctCalculator::Inverse() {
     impl_->Inverse();
 }
 
+void DctCalculator::InverseScaled(size_t scale) {
+    impl_->InverseScaled(scale);
+}
+
 DctCalculator::~DctCalculator() = default;
+
+BatchDctCalculator::BatchDctCalculator(size_t width)
+    : width_(width), scale_(width * width), plans_(width ? GetPlans(width) : nullptr) {
+    for (size_t i = 0; i < width; ++i) {
+        for (size_t j = 0; j < width; ++j) {
+            scale_[i * width + j] = (i == 0 ? sqrt(2) : 1) * (j == 0 ? sqrt(2) : 1) / 16;
+        }
+    }
+}
+
+void BatchDctCalculator::Inverse(std::span<const double> input, std::span<double> output) {
+    auto size = scale_.size();
+    if (size == 0 || input.size() != output.size() || input.size() % size != 0) {
+        throw std::invalid_argument("bad");
+    }
+    if (input.empty()) {
+        return;
+    }
+
+    // The transform is linear, so scaling the input replaces dividing the output.
+    for (size_t i = 0; i < input.size(); ++i) {
+        output[i] = input[i] * scale_[i % size];
+    }
+    auto blocks = input.size() / size;
+    size_t block = 0;
+    for (; block + kBatchBlocks <= blocks; block += kBatchBlocks) {
+        auto data = output.data() + block * size;
+        fftw_execute_r2r(plans_->batch, data, data);
+    }
+    for (; block < blocks; ++block) {
+        auto data = output.data() + block * size;
+        fftw_execute_r2r(plans_->single, data, data);
+    }
+}
+
+BatchDctCalculator::~BatchDctCalculator() = default;
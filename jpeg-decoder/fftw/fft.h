@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+
+enum class DctBackend {
+    FFTW,         // any width, in double precision
+    FIXED_POINT,  // 8x8 only, the integer IDCT from idct.h
+};
+
+class DctCalculator {
+public:
+    // input and output are width by width matrices, first row, then
+    // the second row.
+    DctCalculator(size_t width, std::vector<double> *input, std::vector<double> *output,
+                  DctBackend backend = DctBackend::FFTW);
+
+    // Inverse DCT of the coefficients in input, without the level shift. The FFTW
+    // backend scales the first row and column of input in place; the fixed point
+    // one rounds input to integers and leaves it intact.
+    void Inverse();
+
+    // Like Inverse, but writes a (width / scale) by (width / scale) matrix to the
+    // start of output, a block downscaled for thumbnails. scale is 1, 2, 4 or 8;
+    // only the fixed point backend supports scales other than 1.
+    void InverseScaled(size_t scale);
+
+    ~DctCalculator();
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+// Inverse DCT of many width by width matrices stored one after another, e.g. all
+// blocks of an MCU row, with one FFTW call per fixed batch of blocks. Plans are
+// made once per width, cached for the process and shared by all calculators, so
+// Inverse may be called from several threads.
+class BatchDctCalculator {
+public:
+    explicit BatchDctCalculator(size_t width);
+
+    BatchDctCalculator(const BatchDctCalculator &) = delete;
+    BatchDctCalculator &operator=(const BatchDctCalculator &) = delete;
+
+    ~BatchDctCalculator();
+
+    // input and output hold the same number of matrices. Unlike DctCalculator,
+    // input is left intact unless it is output. Matches DctCalculator::Inverse up to
+    // rounding.
+    void Inverse(std::span<const double> input, std::span<double> output);
+
+private:
+    class Plans;
+    static std::shared_ptr<const Plans> GetPlans(int width);
+
+    size_t width_;
+    std::vector<double> scale_;  // applied to the input, including the final 1/16
+    std::shared_ptr<const Plans> plans_;
+};
@@ -0,0 +1,260 @@
+#include "idct.h"
+#include <stdexcept>
+#include "idct_llm.h"
+
+#if defined(__x86_64__)
+#include <emmintrin.h>
+
+// Defined in idct_avx2.cpp, which is compiled with AVX2 enabled.
+void InverseDct8x8Avx2(int32_t *block);
+#endif
+
+namespace {
+
+struct ScalarOps {
+    static int32_t Add(int32_t a, int32_t b) {
+        return a + b;
+    }
+    static int32_t Sub(int32_t a, int32_t b) {
+        return a - b;
+    }
+    static int32_t Mul(int32_t a, int32_t c) {
+        return a * c;
+    }
+    static int32_t Shl(int32_t a, int bits) {
+        return a << bits;
+    }
+    static int32_t Sar(int32_t a, int bits) {
+        return a >> bits;
+    }
+    static int32_t Set(int32_t c) {
+        return c;
+    }
+};
+
+void InverseDct8x8Scalar(int32_t *block) {
+    int32_t in[8];
+    int32_t out[8];
+    int32_t workspace[64];
+
+    // Columns.
+    for (int col = 0; col < 8; ++col) {
+        for (int i = 0; i < 8; ++i) {
+            in[i] = block[i * 8 + col];
+        }
+        idct_llm::Transform<ScalarOps>(in, out, idct_llm::kPass1Shift);
+        for (int i = 0; i < 8; ++i) {
+            workspace[i * 8 + col] = out[i];
+        }
+    }
+
+    // Rows.
+    for (int row = 0; row < 8; ++row) {
+        idct_llm::Transform<ScalarOps>(workspace + row * 8, block + row * 8,
+                                       idct_llm::kPass2Shift);
+    }
+}
+
+// Constants of the reduced transforms scaled by 2^kConstBits.
+constexpr int32_t kFix0211164243 = 1730;
+constexpr int32_t kFix0509795579 = 4176;
+constexpr int32_t kFix0601344887 = 4926;
+constexpr int32_t kFix0720959822 = 5906;
+constexpr int32_t kFix0850430095 = 6967;
+constexpr int32_t kFix1061594337 = 8697;
+constexpr int32_t kFix1272758580 = 10426;
+constexpr int32_t kFix1451774981 = 11893;
+constexpr int32_t kFix2172734803 = 17799;
+constexpr int32_t kFix3624509785 = 29692;
+
+int32_t Descale(int32_t value, int shift) {
+    return (value + (1 << (shift - 1))) >> shift;
+}
+
+// 4 samples out of the 8 coefficients in[0], in[stride], ... in[7 * stride];
+// the 4th one doesn't contribute.
+void Reduced4(const int32_t *in, size_t stride, int32_t *out, size_t out_stride, int shift) {
+    using namespace idct_llm;
+    auto coef = [in, stride](int i) { return in[i * stride]; };
+
+    // Even part.
+    auto tmp0 = coef(0) * (1 << (kConstBits + 1));
+    auto tmp2 = coef(2) * kFix1847759065 - coef(6) * kFix0765366865;
+    auto tmp10 = tmp0 + tmp2;
+    auto tmp12 = tmp0 - tmp2;
+
+    // Odd part.
+    tmp0 = -coef(7) * kFix0211164243 + coef(5) * kFix1451774981 - coef(3) * kFix2172734803 +
+           coef(1) * kFix1061594337;
+    tmp2 = -coef(7) * kFix0509795579 - coef(5) * kFix0601344887 + coef(3) * kFix0899976223 +
+           coef(1) * kFix2562915447;
+
+    out[0] = Descale(tmp10 + tmp2, shift + 1);
+    out[3 * out_stride] = Descale(tmp10 - tmp2, shift + 1);
+    out[out_stride] = Descale(tmp12 + tmp0, shift + 1);
+    out[2 * out_stride] = Descale(tmp12 - tmp0, shift + 1);
+}
+
+// 2 samples out of the coefficients 0, 1, 3, 5 and 7.
+void Reduced2(const int32_t *in, size_t stride, int32_t *out, size_t out_stride, int shift) {
+    using namespace idct_llm;
+    auto coef = [in, stride](int i) { return in[i * stride]; };
+
+    auto tmp10 = coef(0) * (1 << (kConstBits + 2));
+    auto tmp0 = -coef(7) * kFix0720959822 + coef(5) * kFix0850430095 -
+                coef(3) * kFix1272758580 + coef(1) * kFix3624509785;
+
+    out[0] = Descale(tmp10 + tmp0, shift + 2);
+    out[out_stride] = Descale(tmp10 - tmp0, shift + 2);
+}
+
+// Columns go first into |workspace|, then rows into the start of |block|.
+template <int kSize>
+void InverseDctReduced(int32_t *block) {
+    constexpr auto transform = kSize == 4 ? Reduced4 : Reduced2;
+    int32_t workspace[kSize * 8];
+
+    for (int col = 0; col < 8; ++col) {
+        if (kSize == 4 ? col == 4 : col % 2 == 0 && col != 0) {
+            continue;  // doesn't contribute to the rows
+        }
+        transform(block + col, 8, workspace + col, 8, idct_llm::kPass1Shift);
+    }
+    for (int row = 0; row < kSize; ++row) {
+        transform(workspace + row * 8, 1, block + row * kSize, 1, idct_llm::kPass2Shift);
+    }
+}
+
+#if defined(__x86_64__)
+
+struct Sse2Ops {
+    static __m128i Add(__m128i a, __m128i b) {
+        return _mm_add_epi32(a, b);
+    }
+    static __m128i Sub(__m128i a, __m128i b) {
+        return _mm_sub_epi32(a, b);
+    }
+    // SSE2 has no 32-bit low multiplication, so even and odd lanes are
+    // multiplied into 64 bits and the low halves are put back together.
+    static __m128i Mul(__m128i a, int32_t c) {
+        auto factor = _mm_set1_epi32(c);
+        auto even = _mm_mul_epu32(a, factor);
+        auto odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), factor);
+        return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                  _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+    }
+    static __m128i Shl(__m128i a, int bits) {
+        return _mm_slli_epi32(a, bits);
+    }
+    static __m128i Sar(__m128i a, int bits) {
+        return _mm_srai_epi32(a, bits);
+    }
+    static __m128i Set(int32_t c) {
+        return _mm_set1_epi32(c);
+    }
+};
+
+void Transpose4x4(const __m128i *in, __m128i *out) {
+    auto t0 = _mm_unpacklo_epi32(in[0], in[1]);
+    auto t1 = _mm_unpacklo_epi32(in[2], in[3]);
+    auto t2 = _mm_unpackhi_epi32(in[0], in[1]);
+    auto t3 = _mm_unpackhi_epi32(in[2], in[3]);
+    out[0] = _mm_unpacklo_epi64(t0, t1);
+    out[1] = _mm_unpackhi_epi64(t0, t1);
+    out[2] = _mm_unpacklo_epi64(t2, t3);
+    out[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+// |left| and |right| hold columns 0-3 and 4-7 of the rows. The result holds
+// rows 0-3 and 4-7 of the columns in the same way.
+void Transpose8x8(const __m128i *left, const __m128i *right, __m128i *top, __m128i *bottom) {
+    Transpose4x4(left, top);
+    Transpose4x4(right, top + 4);
+    Transpose4x4(left + 4, bottom);
+    Transpose4x4(right + 4, bottom + 4);
+}
+
+void InverseDct8x8Sse2(int32_t *block) {
+    __m128i left[8], right[8], top[8], bottom[8];
+    for (int i = 0; i < 8; ++i) {
+        left[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i * 8));
+        right[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i * 8 + 4));
+    }
+
+    idct_llm::Transform<Sse2Ops>(left, left, idct_llm::kPass1Shift);
+    idct_llm::Transform<Sse2Ops>(right, right, idct_llm::kPass1Shift);
+    Transpose8x8(left, right, top, bottom);
+    idct_llm::Transform<Sse2Ops>(top, top, idct_llm::kPass2Shift);
+    idct_llm::Transform<Sse2Ops>(bottom, bottom, idct_llm::kPass2Shift);
+    Transpose8x8(top, bottom, left, right);
+
+    for (int i = 0; i < 8; ++i) {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(block + i * 8), left[i]);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(block + i * 8 + 4), right[i]);
+    }
+}
+
+#endif
+
+}  // namespace
+
+bool IsSupported(IdctKernel kernel) {
+    switch (kernel) {
+        case IdctKernel::SCALAR:
+            return true;
+#if defined(__x86_64__)
+        case IdctKernel::SSE2:
+            return true;
+        case IdctKernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+IdctKernel GetBestIdctKernel() {
+    static const auto kBest = [] {
+        for (auto kernel : {IdctKernel::AVX2, IdctKernel::SSE2}) {
+            if (IsSupported(kernel)) {
+                return kernel;
+            }
+        }
+        return IdctKernel::SCALAR;
+    }();
+    return kBest;
+}
+
+void InverseDct8x8(int32_t *block, IdctKernel kernel) {
+    if (!IsSupported(kernel)) {
+        throw std::invalid_argument("bad");
+    }
+    switch (kernel) {
+#if defined(__x86_64__)
+        case IdctKernel::SSE2:
+            InverseDct8x8Sse2(block);
+            return;
+        case IdctKernel::AVX2:
+            InverseDct8x8Avx2(block);
+            return;
+#endif
+        default:
+            InverseDct8x8Scalar(block);
+    }
+}
+
+void InverseDctScaled(int32_t *block, int size) {
+    switch (size) {
+        case 4:
+            InverseDctReduced<4>(block);
+            return;
+        case 2:
+            InverseDctReduced<2>(block);
+            return;
+        case 1:
+            block[0] = Descale(block[0], 3);
+            return;
+        default:
+            throw std::invalid_argument("bad");
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+// Fixed point 8x8 inverse DCT, the LLM algorithm from libjpeg's jidctint.c.
+// All kernels give bit-exact results.
+enum class IdctKernel {
+    SCALAR,
+    SSE2,
+    AVX2,
+};
+
+// The fastest kernel the CPU supports.
+IdctKernel GetBestIdctKernel();
+
+bool IsSupported(IdctKernel kernel);
+
+// Transforms the 64 coefficients of |block|, row by row, into samples in place.
+// Samples are rounded but neither level-shifted nor clamped.
+void InverseDct8x8(int32_t *block, IdctKernel kernel);
+
+// Reduced transforms for decoding at 1/2, 1/4 or 1/8 scale, as in libjpeg's
+// jidctred.c. They turn the coefficients of |block| into |size| by |size| samples,
+// |size| being 4, 2 or 1, stored row by row at the start of |block|. Coefficients
+// that don't affect the smaller output are skipped.
+void InverseDctScaled(int32_t *block, int size);
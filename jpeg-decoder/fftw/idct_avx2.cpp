@@ -0,0 +1,67 @@
+// Only the AVX2 kernel lives here, as the file is compiled with -mavx2.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#include <cstdint>
+#include "idct_llm.h"
+
+namespace {
+
+struct Avx2Ops {
+    static __m256i Add(__m256i a, __m256i b) {
+        return _mm256_add_epi32(a, b);
+    }
+    static __m256i Sub(__m256i a, __m256i b) {
+        return _mm256_sub_epi32(a, b);
+    }
+    static __m256i Mul(__m256i a, int32_t c) {
+        return _mm256_mullo_epi32(a, _mm256_set1_epi32(c));
+    }
+    static __m256i Shl(__m256i a, int bits) {
+        return _mm256_slli_epi32(a, bits);
+    }
+    static __m256i Sar(__m256i a, int bits) {
+        return _mm256_srai_epi32(a, bits);
+    }
+    static __m256i Set(int32_t c) {
+        return _mm256_set1_epi32(c);
+    }
+};
+
+void Transpose8x8(__m256i *rows) {
+    __m256i t[8], u[8];
+    for (int i = 0; i < 4; ++i) {
+        t[2 * i] = _mm256_unpacklo_epi32(rows[2 * i], rows[2 * i + 1]);
+        t[2 * i + 1] = _mm256_unpackhi_epi32(rows[2 * i], rows[2 * i + 1]);
+    }
+    for (int i = 0; i < 2; ++i) {
+        u[4 * i] = _mm256_unpacklo_epi64(t[4 * i], t[4 * i + 2]);
+        u[4 * i + 1] = _mm256_unpackhi_epi64(t[4 * i], t[4 * i + 2]);
+        u[4 * i + 2] = _mm256_unpacklo_epi64(t[4 * i + 1], t[4 * i + 3]);
+        u[4 * i + 3] = _mm256_unpackhi_epi64(t[4 * i + 1], t[4 * i + 3]);
+    }
+    // Each 128-bit half of u[i] now holds 4 rows of columns i and i + 4.
+    for (int i = 0; i < 4; ++i) {
+        rows[i] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x20);
+        rows[i + 4] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x31);
+    }
+}
+
+}  // namespace
+
+void InverseDct8x8Avx2(int32_t *block) {
+    __m256i rows[8];
+    for (int i = 0; i < 8; ++i) {
+        rows[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + i * 8));
+    }
+
+    idct_llm::Transform<Avx2Ops>(rows, rows, idct_llm::kPass1Shift);
+    Transpose8x8(rows);
+    idct_llm::Transform<Avx2Ops>(rows, rows, idct_llm::kPass2Shift);
+    Transpose8x8(rows);
+
+    for (int i = 0; i < 8; ++i) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(block + i * 8), rows[i]);
+    }
+}
+
+#endif
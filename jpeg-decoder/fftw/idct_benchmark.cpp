@@ -0,0 +1,101 @@
+// Blocks per second of every IdctKernel and of the FFTW calculators. Not part of
+// a build target, from this directory:
+//   g++ -std=c++20 -O2 -mavx2 -c idct_avx2.cpp
+//   g++ -std=c++20 -O2 -I. idct_benchmark.cpp idct.cpp fft.cpp idct_avx2.o -lfftw3
+//   ./a.out [blocks]
+//
+// The blocks are sparse like those of a typical baseline JPEG: a DC coefficient
+// and a few low frequency AC ones. Every backend transforms all of them over and
+// over for a fixed time.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "fft.h"
+#include "idct.h"
+
+namespace {
+
+constexpr std::chrono::milliseconds kDuration{500};
+
+std::vector<int32_t> MakeBlocks(size_t blocks) {
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int32_t> dc(-1024, 1023);
+    std::uniform_int_distribution<int32_t> ac(-64, 63);
+    std::uniform_int_distribution<int> position(1, 20);
+    std::vector<int32_t> coefficients(blocks * 64);
+    for (size_t i = 0; i < blocks; ++i) {
+        coefficients[i * 64] = dc(rng);
+        for (int j = 0; j < 6; ++j) {
+            coefficients[i * 64 + position(rng)] = ac(rng);
+        }
+    }
+    return coefficients;
+}
+
+// Millions of blocks per second of |pass|, which transforms |blocks| blocks.
+double Measure(size_t blocks, const std::function<void()> &pass) {
+    size_t passes = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed{};
+    while (elapsed < kDuration) {
+        pass();
+        ++passes;
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    return passes * blocks / elapsed.count() / 1e6;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    auto blocks = argc > 1 ? std::atoi(argv[1]) : 1 << 14;
+    if (blocks < 1) {
+        std::fprintf(stderr, "usage: %s [blocks]\n", argv[0]);
+        return 1;
+    }
+
+    auto coefficients = MakeBlocks(blocks);
+    std::printf("%d blocks, Mblocks/s\n", blocks);
+
+    std::vector<int32_t> samples(coefficients.size());
+    for (auto [kernel, name] : {std::pair{IdctKernel::SCALAR, "scalar"},
+                                std::pair{IdctKernel::SSE2, "sse2"},
+                                std::pair{IdctKernel::AVX2, "avx2"}}) {
+        if (!IsSupported(kernel)) {
+            std::printf("%-16s %10s\n", name, "-");
+            continue;
+        }
+        std::printf("%-16s %10.2f\n", name, Measure(blocks, [&] {
+                        samples = coefficients;
+                        for (int i = 0; i < blocks; ++i) {
+                            InverseDct8x8(samples.data() + i * 64, kernel);
+                        }
+                    }));
+    }
+
+    std::vector<double> input(64);
+    std::vector<double> output(64);
+    for (auto [backend, name] : {std::pair{DctBackend::FIXED_POINT, "fixed point"},
+                                 std::pair{DctBackend::FFTW, "fftw"}}) {
+        DctCalculator calculator(8, &input, &output, backend);
+        std::printf("%-16s %10.2f\n", name, Measure(blocks, [&] {
+                        for (int i = 0; i < blocks; ++i) {
+                            input.assign(coefficients.begin() + i * 64,
+                                         coefficients.begin() + (i + 1) * 64);
+                            calculator.Inverse();
+                        }
+                    }));
+    }
+
+    std::vector<double> batch_input(coefficients.begin(), coefficients.end());
+    std::vector<double> batch_output(batch_input.size());
+    BatchDctCalculator batch(8);
+    std::printf("%-16s %10.2f\n", "fftw batch",
+                Measure(blocks, [&] { batch.Inverse(batch_input, batch_output); }));
+}
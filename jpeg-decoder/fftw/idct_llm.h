@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+
+// The one-dimensional LLM transform shared by the IDCT kernels. |Ops| implements
+// arithmetic on vectors of int32 lanes, so a single call transforms as many
+// columns (or rows) of a block as a vector has lanes.
+namespace idct_llm {
+
+constexpr int kConstBits = 13;
+constexpr int kPass1Bits = 2;
+
+// The first pass keeps kPass1Bits of extra precision, the second one also
+// divides by 8.
+constexpr int kPass1Shift = kConstBits - kPass1Bits;
+constexpr int kPass2Shift = kConstBits + kPass1Bits + 3;
+
+// Constants scaled by 2^kConstBits.
+constexpr int32_t kFix0298631336 = 2446;
+constexpr int32_t kFix0390180644 = 3196;
+constexpr int32_t kFix0541196100 = 4433;
+constexpr int32_t kFix0765366865 = 6270;
+constexpr int32_t kFix0899976223 = 7373;
+constexpr int32_t kFix1175875602 = 9633;
+constexpr int32_t kFix1501321110 = 12299;
+constexpr int32_t kFix1847759065 = 15137;
+constexpr int32_t kFix1961570560 = 16069;
+constexpr int32_t kFix2053119869 = 16819;
+constexpr int32_t kFix2562915447 = 20995;
+constexpr int32_t kFix3072711026 = 25172;
+
+// |in| are the 8 coefficients, |out| the 8 samples scaled down by |shift| bits.
+template <class Ops, class V>
+inline void Transform(const V *in, V *out, int shift) {
+    // Even part.
+    auto z1 = Ops::Mul(Ops::Add(in[2], in[6]), kFix0541196100);
+    auto tmp2 = Ops::Add(z1, Ops::Mul(in[6], -kFix1847759065));
+    auto tmp3 = Ops::Add(z1, Ops::Mul(in[2], kFix0765366865));
+
+    auto tmp0 = Ops::Shl(Ops::Add(in[0], in[4]), kConstBits);
+    auto tmp1 = Ops::Shl(Ops::Sub(in[0], in[4]), kConstBits);
+
+    auto tmp10 = Ops::Add(tmp0, tmp3);
+    auto tmp13 = Ops::Sub(tmp0, tmp3);
+    auto tmp11 = Ops::Add(tmp1, tmp2);
+    auto tmp12 = Ops::Sub(tmp1, tmp2);
+
+    // Odd part.
+    tmp0 = in[7];
+    tmp1 = in[5];
+    tmp2 = in[3];
+    tmp3 = in[1];
+
+    z1 = Ops::Add(tmp0, tmp3);
+    auto z2 = Ops::Add(tmp1, tmp2);
+    auto z3 = Ops::Add(tmp0, tmp2);
+    auto z4 = Ops::Add(tmp1, tmp3);
+    auto z5 = Ops::Mul(Ops::Add(z3, z4), kFix1175875602);
+
+    tmp0 = Ops::Mul(tmp0, kFix0298631336);
+    tmp1 = Ops::Mul(tmp1, kFix2053119869);
+    tmp2 = Ops::Mul(tmp2, kFix3072711026);
+    tmp3 = Ops::Mul(tmp3, kFix1501321110);
+    z1 = Ops::Mul(z1, -kFix0899976223);
+    z2 = Ops::Mul(z2, -kFix2562915447);
+    z3 = Ops::Add(Ops::Mul(z3, -kFix1961570560), z5);
+    z4 = Ops::Add(Ops::Mul(z4, -kFix0390180644), z5);
+
+    tmp0 = Ops::Add(tmp0, Ops::Add(z1, z3));
+    tmp1 = Ops::Add(tmp1, Ops::Add(z2, z4));
+    tmp2 = Ops::Add(tmp2, Ops::Add(z2, z3));
+    tmp3 = Ops::Add(tmp3, Ops::Add(z1, z4));
+
+    auto descale = [shift](auto value) {
+        return Ops::Sar(Ops::Add(value, Ops::Set(int32_t{1} << (shift - 1))), shift);
+    };
+    out[0] = descale(Ops::Add(tmp10, tmp3));
+    out[7] = descale(Ops::Sub(tmp10, tmp3));
+    out[1] = descale(Ops::Add(tmp11, tmp2));
+    out[6] = descale(Ops::Sub(tmp11, tmp2));
+    out[2] = descale(Ops::Add(tmp12, tmp1));
+    out[5] = descale(Ops::Sub(tmp12, tmp1));
+    out[3] = descale(Ops::Add(tmp13, tmp0));
+    out[4] = descale(Ops::Sub(tmp13, tmp0));
+}
+
+}  // namespace idct_llm
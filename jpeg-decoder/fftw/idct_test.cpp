@@ -0,0 +1,119 @@
+// Every IdctKernel against the double precision FFTW transform of DctCalculator.
+// Not part of a build target, from this directory:
+//   g++ -std=c++20 -O2 -mavx2 -c idct_avx2.cpp
+//   g++ -std=c++20 -O2 -I. idct_test.cpp idct.cpp fft.cpp idct_avx2.o -lfftw3
+//
+// Blocks are the rounded forward DCTs of random samples, as in a baseline JPEG,
+// plus sparse blocks with large coefficients. As in the IEEE 1180 accuracy test,
+// every output sample must be within 1 of the rounded exact transform, and the
+// error has to stay small on average.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <numbers>
+#include <random>
+#include <vector>
+
+#include "fft.h"
+#include "idct.h"
+
+namespace {
+
+constexpr int kBlocks = 20000;
+
+void Check(bool condition, const char *what) {
+    if (!condition) {
+        std::fprintf(stderr, "failed: %s\n", what);
+        std::exit(1);
+    }
+}
+
+// Rounded forward DCT of 8x8 |samples|, the coefficients an encoder would store.
+std::vector<double> ForwardDct(const std::vector<double> &samples) {
+    std::vector<double> coefficients(64);
+    for (int v = 0; v < 8; ++v) {
+        for (int u = 0; u < 8; ++u) {
+            double sum = 0;
+            for (int y = 0; y < 8; ++y) {
+                for (int x = 0; x < 8; ++x) {
+                    sum += samples[y * 8 + x] * std::cos((2 * x + 1) * u * std::numbers::pi / 16) *
+                           std::cos((2 * y + 1) * v * std::numbers::pi / 16);
+                }
+            }
+            auto cu = u == 0 ? std::numbers::sqrt2 / 2 : 1;
+            auto cv = v == 0 ? std::numbers::sqrt2 / 2 : 1;
+            coefficients[v * 8 + u] = std::round(sum * cu * cv / 4);
+        }
+    }
+    return coefficients;
+}
+
+std::vector<double> MakeBlock(std::mt19937 *rng, int i) {
+    if (i % 2 == 0) {
+        std::uniform_int_distribution<int> sample(-128, 127);
+        std::vector<double> samples(64);
+        for (auto &value : samples) {
+            value = sample(*rng);
+        }
+        return ForwardDct(samples);
+    }
+    std::uniform_int_distribution<int> coefficient(-1024, 1023);
+    std::uniform_int_distribution<int> position(0, 63);
+    std::vector<double> block(64);
+    for (int j = i % 7; j >= 0; --j) {
+        block[position(*rng)] = coefficient(*rng);
+    }
+    return block;
+}
+
+}  // namespace
+
+int main() {
+    std::vector<double> input(64);
+    std::vector<double> exact(64);
+    DctCalculator calculator(8, &input, &exact);
+
+    std::mt19937 rng(1);
+    double total_error = 0;
+    double total_squared_error = 0;
+    for (int i = 0; i < kBlocks; ++i) {
+        auto block = MakeBlock(&rng, i);
+        input = block;
+        calculator.Inverse();
+
+        int32_t reference[64];
+        for (int j = 0; j < 64; ++j) {
+            reference[j] = static_cast<int32_t>(block[j]);
+        }
+        InverseDct8x8(reference, IdctKernel::SCALAR);
+        for (int j = 0; j < 64; ++j) {
+            auto error = reference[j] - std::round(exact[j]);
+            Check(std::abs(error) <= 1, "within 1 of FFTW");
+            total_error += error;
+            total_squared_error += error * error;
+        }
+
+        for (auto kernel : {IdctKernel::SSE2, IdctKernel::AVX2}) {
+            if (!IsSupported(kernel)) {
+                continue;
+            }
+            int32_t samples[64];
+            for (int j = 0; j < 64; ++j) {
+                samples[j] = static_cast<int32_t>(block[j]);
+            }
+            InverseDct8x8(samples, kernel);
+            for (int j = 0; j < 64; ++j) {
+                Check(samples[j] == reference[j], "bit-exact with the scalar kernel");
+            }
+        }
+    }
+
+    auto samples = 64.0 * kBlocks;
+    std::printf("mean error %.4f, mean squared error %.4f\n", total_error / samples,
+                total_squared_error / samples);
+    Check(std::abs(total_error / samples) <= 0.015, "mean error");
+    Check(total_squared_error / samples <= 0.02, "mean squared error");
+    std::puts("ok");
+}
@@ -1 +1,5 @@
-add_library(decoder_fftw fft.cpp)
+add_library(decoder_fftw fft.cpp idct.cpp idct_avx2.cpp)
+
+if (CMAKE_SYSTEM_PROCESSOR MATCHES "x86_64|AMD64")
+    set_source_files_properties(idct_avx2.cpp PROPERTIES COMPILE_OPTIONS -mavx2)
+endif()
@@ -0,0 +1,128 @@
+#include "bit_reader.h"
+#include <stdexcept>
+
+namespace {
+
+constexpr uint8_t kMarker = 0xFF;
+constexpr uint8_t kFirstRestart = 0xD0;
+constexpr uint8_t kLastRestart = 0xD7;
+
+uint64_t LoadBigEndian(const uint8_t* data) {
+    uint64_t word = 0;
+    for (int i = 0; i < 8; ++i) {
+        word = (word << 8) | data[i];
+    }
+    return word;
+}
+
+bool HasMarkerByte(uint64_t word) {
+    // Looks for a zero byte in ~word.
+    auto inverted = ~word;
+    return ((inverted - 0x0101010101010101ull) & ~inverted & 0x8080808080808080ull) != 0;
+}
+
+}  // namespace
+
+BitReader::BitReader(std::span<const uint8_t> data) : data_(data) {
+}
+
+uint32_t BitReader::Peek(int count) {
+    if (count < 0 || count > kMaxPeekBits) {
+        throw std::invalid_argument("bad");
+    }
+    if (bits_ < count) {
+        Refill();
+    }
+    // Shifted in two steps so that |count| == 0 is fine.
+    return (buffer_ >> 1) >> (63 - count);
+}
+
+void BitReader::Consume(int count) {
+    if (count < 0 || count > bits_ - padding_) {
+        throw std::invalid_argument("bad");
+    }
+    buffer_ = count == 64 ? 0 : buffer_ << count;
+    bits_ -= count;
+}
+
+uint32_t BitReader::Read(int count) {
+    auto bits = Peek(count);
+    Consume(count);
+    return bits;
+}
+
+uint8_t BitReader::Decode(const HuffmanTree& tree) {
+    int length;
+    auto value = tree.Decode(Peek(HuffmanTree::kMaxCodeLength), length);
+    Consume(length);
+    return value;
+}
+
+int BitReader::ReadRestartMarker() {
+    Refill();
+    if (!at_marker_ || bits_ - padding_ >= 8) {
+        throw std::invalid_argument("bad");
+    }
+    // Any number of 0xFF fill bytes may precede the marker code.
+    while (position_ + 1 < data_.size() && data_[position_ + 1] == kMarker) {
+        ++position_;
+    }
+    if (position_ + 1 >= data_.size()) {
+        throw std::invalid_argument("bad");
+    }
+    auto marker = data_[position_ + 1];
+    if (marker < kFirstRestart || marker > kLastRestart) {
+        throw std::invalid_argument("bad");
+    }
+
+    position_ += 2;
+    buffer_ = 0;
+    bits_ = 0;
+    padding_ = 0;
+    at_marker_ = false;
+    return marker - kFirstRestart;
+}
+
+size_t BitReader::GetPosition() const {
+    return position_;
+}
+
+void BitReader::Refill() {
+    if (bits_ > 56) {
+        return;
+    }
+
+    // Most of the segment has no 0xFF bytes, so the whole bytes that fit are
+    // taken from a single 8 byte load.
+    if (!at_marker_ && position_ + 8 <= data_.size()) {
+        auto word = LoadBigEndian(data_.data() + position_);
+        if (!HasMarkerByte(word)) {
+            auto bytes = (64 - bits_) / 8;
+            if (bytes == 8) {
+                buffer_ = word;
+            } else {
+                buffer_ |= (word >> (64 - bytes * 8)) << (64 - bits_ - bytes * 8);
+            }
+            bits_ += bytes * 8;
+            position_ += bytes;
+            return;
+        }
+    }
+
+    while (bits_ <= 56) {
+        uint64_t byte = 0;
+        if (at_marker_ || position_ >= data_.size()) {
+            padding_ += 8;
+        } else if (data_[position_] != kMarker) {
+            byte = data_[position_++];
+        } else if (position_ + 1 < data_.size() && data_[position_ + 1] == 0) {
+            byte = kMarker;
+            position_ += 2;
+        } else {
+            at_marker_ = true;
+            padding_ += 8;
+        }
+        buffer_ |= byte << (56 - bits_);
+        bits_ += 8;
+    }
+}
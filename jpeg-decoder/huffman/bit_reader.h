@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "huffman.h"
+
+// Reads bits of an entropy-coded segment, the first bit in the most significant
+// bit of a byte. Zero bytes stuffed after 0xFF are dropped. The segment ends at
+// the first marker or the end of data; past it the lookahead is padded with
+// zeros, but consuming padding throws.
+class BitReader {
+public:
+    explicit BitReader(std::span<const uint8_t> data);
+
+    // Longest lookahead of Peek.
+    static constexpr int kMaxPeekBits = 32;
+
+    // Returns the next |count| bits without consuming them, |count| <= kMaxPeekBits.
+    uint32_t Peek(int count);
+
+    // Skips |count| bits that were peeked before.
+    void Consume(int count);
+
+    uint32_t Read(int count);
+
+    // Reads one symbol coded by |tree|.
+    uint8_t Decode(const HuffmanTree& tree);
+
+    // Skips the fill bits of the current byte and the restart marker following them.
+    // Returns the number of the marker. Throws if there's no restart marker here.
+    int ReadRestartMarker();
+
+    // Offset in the data of the next byte not loaded yet. Once the segment is over,
+    // it's the offset of the marker that ends it.
+    size_t GetPosition() const;
+
+private:
+    // Loads bytes until the buffer holds more than 56 bits.
+    void Refill();
+
+    std::span<const uint8_t> data_;
+    size_t position_ = 0;
+
+    // Buffered bits are aligned to the most significant bit. The last |padding_|
+    // of them are zeros added after the end of the segment.
+    uint64_t buffer_ = 0;
+    int bits_ = 0;
+    int padding_ = 0;
+    bool at_marker_ = false;
+};
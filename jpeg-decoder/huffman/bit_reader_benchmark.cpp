@@ -0,0 +1,174 @@
+// Throughput of BitReader on a synthetic entropy-coded segment. Not part of a
+// build target, from this directory:
+//   g++ -std=c++20 -O2 bit_reader_benchmark.cpp bit_reader.cpp huffman.cpp
+//   ./a.out [kilobytes] [interval bytes]
+//
+// The segment holds random bytes, so about one in 256 is a 0xFF with a stuffed
+// zero after it, and is split into restart intervals by RSTn markers. It's read
+// over and over for a fixed time in chunks of a fixed number of bits, and in
+// chunks of 1 to 16 bits peeked 16 at a time as Decode does. The bit loop reads
+// one bit at a time and drops stuffed zeros itself, as callers of
+// HuffmanTree::Move did.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "bit_reader.h"
+
+namespace {
+
+constexpr std::chrono::milliseconds kDuration{500};
+
+// Keeps the hashes of timed passes from being optimized away.
+volatile uint64_t sink;
+
+// Number of bits of the |i|-th chunk in the 1 to 16 bit row.
+int VaryingCount(size_t i) {
+    return i % 16 + 1;
+}
+
+struct Segment {
+    std::vector<uint8_t> bytes;
+    size_t intervals;
+    size_t interval_bits;
+};
+
+Segment MakeSegment(size_t payload, size_t interval) {
+    std::mt19937 rng(1);
+    Segment segment{{}, (payload + interval - 1) / interval, interval * 8};
+    for (size_t i = 0; i < segment.intervals * interval; ++i) {
+        if (i > 0 && i % interval == 0) {
+            segment.bytes.push_back(0xFF);
+            segment.bytes.push_back(0xD0 + i / interval % 8);
+        }
+        auto byte = static_cast<uint8_t>(rng());
+        segment.bytes.push_back(byte);
+        if (byte == 0xFF) {
+            segment.bytes.push_back(0);
+        }
+    }
+    segment.bytes.push_back(0xFF);
+    segment.bytes.push_back(0xD9);
+    return segment;
+}
+
+// Reads a bit at a time from whole bytes of the segment.
+class BitLoop {
+public:
+    explicit BitLoop(const std::vector<uint8_t>& bytes) : bytes_(bytes) {
+    }
+
+    uint32_t Read(int count) {
+        uint32_t bits = 0;
+        for (int i = 0; i < count; ++i) {
+            if (bit_ == 0) {
+                byte_ = bytes_[position_++];
+                if (byte_ == 0xFF) {
+                    ++position_;
+                }
+                bit_ = 8;
+            }
+            bits = (bits << 1) | ((byte_ >> --bit_) & 1);
+        }
+        return bits;
+    }
+
+    void SkipRestartMarker() {
+        position_ += 2;
+    }
+
+private:
+    const std::vector<uint8_t>& bytes_;
+    size_t position_ = 0;
+    uint8_t byte_ = 0;
+    int bit_ = 0;
+};
+
+// Reads the whole segment in chunks of |count| bits, or of VaryingCount bits if
+// |count| is 0, and returns a hash of the chunks.
+uint64_t ReadBitLoop(const Segment& segment, int count) {
+    BitLoop loop(segment.bytes);
+    uint64_t hash = 0;
+    for (size_t interval = 0; interval < segment.intervals; ++interval) {
+        if (interval > 0) {
+            loop.SkipRestartMarker();
+        }
+        size_t i = 0;
+        for (size_t left = segment.interval_bits; left > 0; ++i) {
+            auto n = static_cast<int>(std::min<size_t>(count ? count : VaryingCount(i), left));
+            hash = hash * 31 + loop.Read(n);
+            left -= n;
+        }
+    }
+    return hash;
+}
+
+uint64_t ReadBitReader(const Segment& segment, int count) {
+    BitReader reader(segment.bytes);
+    uint64_t hash = 0;
+    for (size_t interval = 0; interval < segment.intervals; ++interval) {
+        if (interval > 0) {
+            reader.ReadRestartMarker();
+        }
+        size_t i = 0;
+        for (size_t left = segment.interval_bits; left > 0; ++i) {
+            auto n = static_cast<int>(std::min<size_t>(count ? count : VaryingCount(i), left));
+            if (count) {
+                hash = hash * 31 + reader.Read(n);
+            } else {
+                hash = hash * 31 + (reader.Peek(16) >> (16 - n));
+                reader.Consume(n);
+            }
+            left -= n;
+        }
+    }
+    return hash;
+}
+
+// Megabytes of payload per second of |pass|, which reads |bytes| bytes of it.
+double Measure(size_t bytes, const std::function<void()>& pass) {
+    size_t passes = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed{};
+    while (elapsed < kDuration) {
+        pass();
+        ++passes;
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    return passes * bytes / elapsed.count() / 1e6;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    auto kilobytes = argc > 1 ? std::atoi(argv[1]) : 16384;
+    auto interval = argc > 2 ? std::atoi(argv[2]) : 4096;
+    if (kilobytes < 1 || interval < 1) {
+        std::fprintf(stderr, "usage: %s [kilobytes] [interval bytes]\n", argv[0]);
+        return 1;
+    }
+
+    auto segment = MakeSegment(kilobytes * size_t{1024}, interval);
+    auto payload = segment.intervals * interval;
+    std::printf("%zu bytes in %zu intervals, MB/s\n", payload, segment.intervals);
+    std::printf("%-6s %10s %12s\n", "bits", "bit loop", "bit reader");
+    for (int count : {1, 4, 8, 16, 32, 0}) {
+        if (ReadBitLoop(segment, count) != ReadBitReader(segment, count)) {
+            std::fprintf(stderr, "%d bits: BitReader read other bits\n", count);
+            return 1;
+        }
+        auto loop = Measure(payload, [&] { sink = ReadBitLoop(segment, count); });
+        auto reader = Measure(payload, [&] { sink = ReadBitReader(segment, count); });
+        if (count) {
+            std::printf("%-6d %10.1f %12.1f\n", count, loop, reader);
+        } else {
+            std::printf("%-6s %10.1f %12.1f\n", "1-16", loop, reader);
+        }
+    }
+}
@@ -0,0 +1,56 @@
+// Restart markers preceded by 0xFF fill bytes. Not part of a build target, from
+// this directory:
+//   g++ -std=c++20 -I../parallel $(ls *.cpp | grep -v _benchmark) ../parallel/thread_pool.cpp
+
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#include "bit_reader.h"
+#include "restart_intervals.h"
+
+namespace {
+
+void Check(bool condition, const char* what) {
+    if (!condition) {
+        std::fprintf(stderr, "failed: %s\n", what);
+        std::exit(1);
+    }
+}
+
+template <class F>
+bool Throws(F&& f) {
+    try {
+        f();
+    } catch (const std::invalid_argument&) {
+        return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+int main() {
+    for (int fill = 0; fill < 4; ++fill) {
+        std::vector<uint8_t> data = {0xAB};
+        data.insert(data.end(), fill, 0xFF);
+        data.insert(data.end(), {0xFF, 0xD0, 0xCD, 0xFF, 0xD9});
+
+        BitReader reader(data);
+        Check(reader.Read(8) == 0xAB, "first interval");
+        Check(reader.ReadRestartMarker() == 0, "marker after fill bytes");
+        Check(reader.Read(8) == 0xCD, "second interval");
+        Check(Throws([&] { reader.ReadRestartMarker(); }), "EOI is not a restart marker");
+
+        auto intervals = SplitRestartIntervals(data);
+        Check(intervals.size() == 2, "split at marker after fill bytes");
+    }
+
+    std::vector<uint8_t> fill_only = {0xAB, 0xFF, 0xFF, 0xFF};
+    BitReader reader(fill_only);
+    reader.Read(8);
+    Check(Throws([&] { reader.ReadRestartMarker(); }), "fill bytes without a marker");
+
+    std::puts("ok");
+}
@@ -1,21 +1,30 @@
 #include "huffman.h"
-#include <list>
+#include <algorithm>
+#include <array>
 #include <memory>
-#include <optional>
-#include <cassert>
 #include <numeric>
 #include <stdexcept>
 
-class HuffmanTree::Impl {
-public:
-    Impl() = default;
+namespace {
+
+// Codes up to kPrimaryBits long are decoded with a single lookup in the primary
+// table. Longer codes take a second lookup in the overflow table of their prefix.
+constexpr int kPrimaryBits = 9;
 
-    Impl(const Impl&) = delete;
-    Impl& operator=(const Impl&) = delete;
+struct Entry {
+    uint8_t length = 0;    // of the code, 0 if no code starts with these bits
+    uint8_t sub_bits = 0;  // if not 0, |value| is the offset of an overflow table
+    uint16_t value = 0;
+};
+
+void Fill(Entry* entries, int count, Entry entry) {
+    std::fill(entries, entries + count, entry);
+}
 
-    Impl(Impl&&);
-    Impl& operator=(Impl&&);
+}  // namespace
 
+class HuffmanTree::Impl {
+public:
     // code_lengths is the array of size no more than 16 with number of
     // terminated nodes in the Huffman tree.
     // values are the values of the terminated nodes in the consecutive
@@ -26,108 +35,126 @@ public:
     // overwrites |value| and resets the tree state. If the node is intermediate, false is
     // returned without changing the value.
     bool Move(bool bit, int& value);
-    ~Impl() = default;
-
-private:
-    struct BuildData {
-        BuildData(const std::vector<uint8_t>& code_lengths, const std::vector<uint8_t>& values)
-            : remaining_leafs(code_lengths), values(values.begin(), values.end()) {
-        }
 
-        bool IsFinished() const {
-            return std::accumulate(remaining_leafs.begin() + depth, remaining_leafs.end(), 0) == 0;
-        }
+    uint8_t Decode(uint16_t bits, int& length) const;
 
-        bool IsTerminal() const {
-            if (depth == 0) {
-                return false;
-            }
-            return remaining_leafs[depth - 1] > 0;
-        }
-
-        uint8_t Pop() {
-            uint8_t ans = values.front();
-            values.pop_front();
-            --remaining_leafs[depth - 1];
-            return ans;
-        }
-
-        std::vector<uint8_t> remaining_leafs;
-        std::list<uint8_t> values;
-        int depth = 0;
-    };
-
-    struct Node;
-    using NodePtr = std::unique_ptr<Node>;
-
-    struct Node {
-        NodePtr left;
-        NodePtr right;
-        std::optional<uint8_t> value;
-    };
-
-    void Build(Node* node, BuildData& data) {
-        if (data.IsTerminal()) {
-            node->value = data.Pop();
-            return;
-        }
-
-        if (data.IsFinished()) {
-            return;
-        }
+private:
+    using Levels = std::array<int, kMaxCodeLength + 1>;
 
-        ++data.depth;
-        node->left = std::make_unique<Node>();
-        Build(node->left.get(), data);
-        --data.depth;
+    void Reset() {
+        code_ = 0;
+        length_ = 0;
+    }
 
-        if (!data.IsFinished()) {
-            ++data.depth;
-            node->right = std::make_unique<Node>();
-            Build(node->right.get(), data);
-            --data.depth;
-        }
+    // Leaves a tree without codes.
+    void Clear() {
+        first_ = leaf_end_ = end_ = offset_ = Levels{};
+        values_.clear();
+        primary_.fill(Entry{});
+        overflow_.clear();
+        Reset();
     }
-    NodePtr root_ = std::make_unique<Node>();
-    Node* cur_node_ = root_.get();
+
+    // Canonical codes of each length are consecutive: codes of length L from
+    // first_[L] to leaf_end_[L] are terminal, codes up to end_[L] are prefixes of
+    // longer codes, and the rest aren't in the tree.
+    Levels first_{};
+    Levels leaf_end_{};
+    Levels end_{};
+    Levels offset_{};  // index in values_ of the value of first_[L]
+    std::vector<uint8_t> values_;
+
+    std::array<Entry, 1 << kPrimaryBits> primary_{};
+    std::vector<Entry> overflow_;
+
+    // The bits passed to Move since the last terminal node.
+    int code_ = 0;
+    int length_ = 0;
 };
 
 void HuffmanTree::Impl::Build(const std::vector<uint8_t>& code_lengths,
                               const std::vector<uint8_t>& values) {
-    root_ = std::make_unique<Node>();
-    cur_node_ = root_.get();
-
-    if (code_lengths.size() > 16) {
+    if (code_lengths.size() > kMaxCodeLength ||
+        std::accumulate(code_lengths.begin(), code_lengths.end(), size_t{0}) != values.size()) {
+        Clear();
         throw std::invalid_argument("bad");
     }
-    if (std::accumulate(code_lengths.begin(), code_lengths.end(), size_t{0}) != values.size()) {
+
+    Levels counts{};
+    std::copy(code_lengths.begin(), code_lengths.end(), counts.begin() + 1);
+
+    // Nodes on each level are the leaves and the inner nodes holding the deeper
+    // levels, two nodes per inner node. The root has room for two nodes.
+    Levels nodes{};
+    for (int length = kMaxCodeLength, deeper = 0; length > 0; --length) {
+        nodes[length] = counts[length] + (deeper + 1) / 2;
+        deeper = nodes[length];
+    }
+    if (nodes[1] > 2) {
+        Clear();
         throw std::invalid_argument("bad");
     }
 
-    auto data = BuildData(code_lengths, values);
+    overflow_.clear();  // keeps the capacity for the next tables
+    Reset();
 
-    Build(root_.get(), data);
+    for (int length = 1, code = 0, offset = 0; length <= kMaxCodeLength; ++length) {
+        first_[length] = code;
+        leaf_end_[length] = code + counts[length];
+        end_[length] = code + nodes[length];
+        offset_[length] = offset;
+        code = leaf_end_[length] << 1;
+        offset += counts[length];
+    }
+    values_ = values;
+
+    // Codes are visited from the last one, so every entry is written once and the
+    // longest code with a given prefix comes first and sizes the overflow table of
+    // the prefix. Codes sharing a prefix are consecutive.
+    size_t covered = 0;
+    int table_prefix = -1;
+    for (int length = kMaxCodeLength; length > 0; --length) {
+        for (int code = leaf_end_[length] - 1; code >= first_[length]; --code) {
+            auto entry = Entry{.length = static_cast<uint8_t>(length),
+                               .value = values_[offset_[length] + code - first_[length]]};
+            if (length <= kPrimaryBits) {
+                auto shift = kPrimaryBits - length;
+                Fill(&primary_[code << shift], 1 << shift, entry);
+                covered = std::max<size_t>(covered, (code + 1) << shift);
+                continue;
+            }
 
-    if (!data.IsFinished()) {
-        throw std::invalid_argument("bad");
+            auto extra = length - kPrimaryBits;
+            auto& table = primary_[code >> extra];
+            if (code >> extra != table_prefix) {
+                table_prefix = code >> extra;
+                table = Entry{.sub_bits = static_cast<uint8_t>(extra),
+                              .value = static_cast<uint16_t>(overflow_.size())};
+                overflow_.resize(overflow_.size() + (1 << extra));
+                covered = std::max<size_t>(covered, table_prefix + 1);
+            }
+            auto shift = table.sub_bits - extra;
+            auto index = table.value + ((code & ((1 << extra) - 1)) << shift);
+            Fill(&overflow_[index], 1 << shift, entry);
+        }
     }
+
+    // Canonical codes take the lowest prefixes, the rest of them aren't codes.
+    Fill(primary_.data() + covered, primary_.size() - covered, Entry{});
 }
 
 bool HuffmanTree::Impl::Move(bool bit, int& value) {
-    if (bit) {
-        cur_node_ = cur_node_->right.get();
-    } else {
-        cur_node_ = cur_node_->left.get();
-    }
+    code_ = (code_ << 1) | bit;
+    ++length_;
 
-    if (!cur_node_) {
-        cur_node_ = root_.get();
+    if (code_ >= end_[length_]) {
+        Reset();
         throw std::invalid_argument("bad");
     }
 
-    if (cur_node_->value) {
-        value = *cur_node_->value;
-        cur_node_ = root_.get();
+    if (code_ < leaf_end_[length_]) {
+        value = values_[offset_[length_] + code_ - first_[length_]];
+        Reset();
 
         return true;
     }
@@ -135,6 +162,20 @@ bool HuffmanTree::Impl::Move(bool bit, int& value) {
     return false;
 }
 
+uint8_t HuffmanTree::Impl::Decode(uint16_t bits, int& length) const {
+    const auto* entry = &primary_[bits >> (kMaxCodeLength - kPrimaryBits)];
+    if (entry->sub_bits) {
+        auto rest = bits & ((1 << (kMaxCodeLength - kPrimaryBits)) - 1);
+        entry = &overflow_[entry->value +
+                           (rest >> (kMaxCodeLength - kPrimaryBits - entry->sub_bits))];
+    }
+    if (!entry->length) {
+        throw std::invalid_argument("bad");
+    }
+    length = entry->length;
+    return entry->value;
+}
+
 HuffmanTree::HuffmanTree() : impl_(std::make_unique<HuffmanTree::Impl>()){};
 
 void HuffmanTree::Build(const std::vector<uint8_t>& code_lengths,
@@ -146,6 +187,10 @@ bool HuffmanTree::Move(bool bit, int& value) {
     return impl_->Move(bit, value);
 }
 
+uint8_t HuffmanTree::Decode(uint16_t bits, int& length) const {
+    return impl_->Decode(bits, length);
+}
+
 HuffmanTree::HuffmanTree(HuffmanTree&&) = default;
 
 HuffmanTree& HuffmanTree::operator=(HuffmanTree&&) = default;
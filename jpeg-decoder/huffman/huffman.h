@@ -27,6 +27,15 @@ public:
     // returned without changing the value.
     bool Move(bool bit, int& value);
 
+    // Longest code length allowed by the DHT section.
+    static constexpr int kMaxCodeLength = 16;
+
+    // Decodes a whole symbol at once. |bits| are the next kMaxCodeLength bits of the
+    // stream, the first one in the most significant bit. Returns the symbol and stores
+    // the length of its code in |length|, so the caller knows how many bits to consume.
+    // Doesn't change the state used by Move.
+    uint8_t Decode(uint16_t bits, int& length) const;
+
     ~HuffmanTree();
 
 private:
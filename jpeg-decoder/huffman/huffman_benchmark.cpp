@@ -0,0 +1,173 @@
+// Symbols per second and build time of HuffmanTree. Not part of a build target,
+// from this directory:
+//   g++ -std=c++20 -O2 huffman_benchmark.cpp huffman.cpp bit_reader.cpp
+//   ./a.out [symbols]
+//
+// Streams are coded with the example tables of JPEG Annex K. Symbols are drawn
+// with probability 2^-length of their codes, as if the tables were optimal for
+// the data, and 0xFF bytes are stuffed as in a scan. Every stream is decoded over
+// and over for a fixed time bit by bit with Move, and a code at a time with
+// BitReader::Decode. Every table is also built over and over, into the same tree
+// as for the scans of a progressive image and into a new tree as for every image.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "bit_reader.h"
+#include "huffman.h"
+
+namespace {
+
+constexpr std::chrono::milliseconds kDuration{500};
+
+struct Table {
+    const char* name;
+    std::vector<uint8_t> code_lengths;
+};
+
+// Only the code lengths matter for decoding speed, the values are 0, 1, ...
+const Table kTables[] = {
+    {"dc luma", {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0}},
+    {"dc chroma", {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0}},
+    {"ac luma", {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d}},
+    {"ac chroma", {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77}},
+};
+
+struct Code {
+    uint16_t bits;
+    int length;
+};
+
+// Canonical codes of |code_lengths|, in the order of the values.
+std::vector<Code> MakeCodes(const std::vector<uint8_t>& code_lengths) {
+    std::vector<Code> codes;
+    uint16_t code = 0;
+    for (int length = 1; length <= HuffmanTree::kMaxCodeLength; ++length) {
+        for (int i = 0; i < code_lengths[length - 1]; ++i) {
+            codes.push_back({code++, length});
+        }
+        code <<= 1;
+    }
+    return codes;
+}
+
+// Coded |symbols| and the bits of the codes one per byte, for Move.
+struct Stream {
+    std::vector<uint8_t> symbols;
+    std::vector<uint8_t> bits;
+    std::vector<uint8_t> bytes;
+};
+
+Stream MakeStream(const std::vector<Code>& codes, size_t symbols) {
+    std::mt19937 rng(1);
+    Stream stream;
+    while (stream.symbols.size() < symbols) {
+        // A uniform 16-bit prefix picks every code with probability 2^-length.
+        auto prefix = static_cast<uint16_t>(rng());
+        for (size_t i = 0; i < codes.size(); ++i) {
+            auto shift = HuffmanTree::kMaxCodeLength - codes[i].length;
+            if (prefix >> shift == codes[i].bits) {
+                stream.symbols.push_back(i);
+                for (int bit = codes[i].length - 1; bit >= 0; --bit) {
+                    stream.bits.push_back(codes[i].bits >> bit & 1);
+                }
+                break;
+            }
+        }
+    }
+
+    // Pads the last byte with ones, as an encoder does.
+    for (size_t i = 0; i < stream.bits.size(); i += 8) {
+        uint8_t byte = 0xFF;
+        for (size_t j = i; j < std::min(i + 8, stream.bits.size()); ++j) {
+            if (!stream.bits[j]) {
+                byte &= ~(0x80 >> (j - i));
+            }
+        }
+        stream.bytes.push_back(byte);
+        if (byte == 0xFF) {
+            stream.bytes.push_back(0);
+        }
+    }
+    return stream;
+}
+
+// Millions of symbols per second of |pass|, which decodes |symbols| symbols.
+double Measure(size_t symbols, const std::function<void()>& pass) {
+    size_t passes = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed{};
+    while (elapsed < kDuration) {
+        pass();
+        ++passes;
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    return passes * symbols / elapsed.count() / 1e6;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    auto symbols = argc > 1 ? std::atoi(argv[1]) : 1 << 20;
+    if (symbols < 1) {
+        std::fprintf(stderr, "usage: %s [symbols]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("%d symbols, Msymbols/s, microseconds per build\n", symbols);
+    std::printf("%-10s %10s %10s %12s %10s %10s\n", "table", "bits/sym", "move", "bit reader",
+                "rebuild", "new tree");
+    for (const auto& [name, code_lengths] : kTables) {
+        auto codes = MakeCodes(code_lengths);
+        std::vector<uint8_t> values(codes.size());
+        std::iota(values.begin(), values.end(), 0);
+        HuffmanTree tree;
+        tree.Build(code_lengths, values);
+        auto stream = MakeStream(codes, symbols);
+
+        std::vector<uint8_t> decoded(symbols);
+        auto move = Measure(symbols, [&] {
+            auto out = decoded.begin();
+            int value;
+            for (auto bit : stream.bits) {
+                if (tree.Move(bit, value)) {
+                    *out++ = value;
+                }
+            }
+        });
+        if (decoded != stream.symbols) {
+            std::fprintf(stderr, "%s: Move decoded other symbols\n", name);
+            return 1;
+        }
+
+        std::fill(decoded.begin(), decoded.end(), 0);
+        auto reader = Measure(symbols, [&] {
+            BitReader bit_reader(stream.bytes);
+            for (auto& symbol : decoded) {
+                symbol = bit_reader.Decode(tree);
+            }
+        });
+        if (decoded != stream.symbols) {
+            std::fprintf(stderr, "%s: BitReader decoded other symbols\n", name);
+            return 1;
+        }
+
+        // Measure gives millions of builds per second, its inverse is microseconds.
+        auto rebuild = 1 / Measure(1, [&] { tree.Build(code_lengths, values); });
+        auto new_tree = 1 / Measure(1, [&] {
+            HuffmanTree fresh;
+            fresh.Build(code_lengths, values);
+        });
+
+        std::printf("%-10s %10.2f %10.1f %12.1f %10.2f %10.2f\n", name,
+                    static_cast<double>(stream.bits.size()) / symbols, move, reader, rebuild,
+                    new_tree);
+    }
+}
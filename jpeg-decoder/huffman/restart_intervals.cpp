@@ -0,0 +1,59 @@
+#include "restart_intervals.h"
+#include <stdexcept>
+#include "thread_pool.h"
+
+namespace {
+
+constexpr uint8_t kMarker = 0xFF;
+constexpr uint8_t kFirstRestart = 0xD0;
+constexpr uint8_t kLastRestart = 0xD7;
+
+}  // namespace
+
+std::vector<std::span<const uint8_t>> SplitRestartIntervals(std::span<const uint8_t> data) {
+    std::vector<std::span<const uint8_t>> intervals;
+    size_t begin = 0;
+    uint8_t expected = kFirstRestart;
+
+    for (size_t i = 0; i < data.size(); ++i) {
+        if (data[i] != kMarker || i + 1 == data.size()) {
+            continue;
+        }
+        auto next = data[i + 1];
+        if (next == 0) {
+            ++i;  // a stuffed byte
+            continue;
+        }
+        if (next == kMarker) {
+            continue;  // fill bytes before a marker
+        }
+        if (next < kFirstRestart || next > kLastRestart) {
+            data = data.first(i);
+            break;
+        }
+        if (next != expected) {
+            throw std::invalid_argument("bad");
+        }
+        expected = expected == kLastRestart ? kFirstRestart : expected + 1;
+
+        intervals.push_back(data.subspan(begin, i - begin));
+        begin = i + 2;
+        ++i;
+    }
+
+    intervals.push_back(data.subspan(begin));
+    return intervals;
+}
+
+void DecodeRestartIntervals(std::span<const uint8_t> data,
+                            const std::function<void(size_t, BitReader*)>& decode,
+                            size_t threads) {
+    auto intervals = SplitRestartIntervals(data);
+    ThreadPool::Default().ParallelFor(
+        intervals.size(),
+        [&](size_t i) {
+            BitReader reader(intervals[i]);
+            decode(i, &reader);
+        },
+        threads);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include "bit_reader.h"
+
+// Splits the entropy-coded data of a scan at its restart markers, which must go
+// in order RST0, RST1, ..., RST7, RST0, ... The scan ends at the end of |data| or
+// at the first other marker. Intervals don't include the markers.
+std::vector<std::span<const uint8_t>> SplitRestartIntervals(std::span<const uint8_t> data);
+
+// Restart intervals don't depend on each other, so they are decoded concurrently:
+// |decode(index, reader)| is called for every interval of the scan on up to
+// |threads| threads of ThreadPool::Default() (all of them by default), |reader|
+// reading the interval. If some calls fail, the error of the first interval is
+// rethrown.
+void DecodeRestartIntervals(std::span<const uint8_t> data,
+                            const std::function<void(size_t, BitReader*)>& decode,
+                            size_t threads = 0);
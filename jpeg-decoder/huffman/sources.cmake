@@ -1 +1,2 @@
-add_library(decoder_huffman huffman.cpp)
+add_library(decoder_huffman huffman.cpp bit_reader.cpp restart_intervals.cpp)
+target_link_libraries(decoder_huffman PUBLIC decoder_parallel)
@@ -0,0 +1,3 @@
+add_library(decoder_parallel thread_pool.cpp)
+
+target_include_directories(decoder_parallel PUBLIC ${CMAKE_CURRENT_LIST_DIR})
@@ -0,0 +1,114 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <utility>
+
+namespace {
+
+thread_local bool in_loop = false;
+
+}  // namespace
+
+struct ThreadPool::Loop {
+    Loop(size_t size, const std::function<void(size_t)>& function) : count(size), body(function) {
+    }
+
+    size_t count;
+    const std::function<void(size_t)>& body;
+    std::atomic<size_t> next = 0;
+    std::atomic_bool failed = false;
+
+    std::mutex error_mutex;
+    size_t error_index = 0;
+    std::exception_ptr error;
+};
+
+ThreadPool::ThreadPool(size_t workers) {
+    for (size_t i = 0; i < workers; ++i) {
+        workers_.emplace_back([this] { Work(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::scoped_lock lock(mutex_);
+        stopped_ = true;
+    }
+    loop_started_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::Default() {
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& body,
+                             size_t threads) {
+    Loop loop(count, body);
+    if (in_loop || count <= 1 || threads == 1 || workers_.empty()) {
+        Run(&loop);
+    } else {
+        if (threads == 0) {
+            threads = workers_.size() + 1;
+        }
+        std::scoped_lock running(loop_mutex_);
+        {
+            std::scoped_lock lock(mutex_);
+            loop_ = &loop;
+            free_slots_ = std::min({threads - 1, workers_.size(), count - 1});
+        }
+        loop_started_.notify_all();
+        Run(&loop);
+
+        std::unique_lock lock(mutex_);
+        loop_ = nullptr;
+        free_slots_ = 0;
+        loop_finished_.wait(lock, [this] { return busy_ == 0; });
+    }
+
+    if (loop.error) {
+        std::rethrow_exception(loop.error);
+    }
+}
+
+void ThreadPool::Work() {
+    std::unique_lock lock(mutex_);
+    while (true) {
+        loop_started_.wait(lock, [this] { return stopped_ || free_slots_ > 0; });
+        if (stopped_) {
+            return;
+        }
+        auto loop = loop_;
+        --free_slots_;
+        ++busy_;
+        lock.unlock();
+        Run(loop);
+        lock.lock();
+        if (--busy_ == 0) {
+            loop_finished_.notify_one();
+        }
+    }
+}
+
+void ThreadPool::Run(Loop* loop) {
+    auto nested = std::exchange(in_loop, true);
+    // Indices are claimed in order, so when a call fails all smaller indices are
+    // claimed already, and the smallest failed one is among the recorded errors.
+    for (size_t i; !loop->failed && (i = loop->next.fetch_add(1)) < loop->count;) {
+        try {
+            loop->body(i);
+        } catch (...) {
+            std::scoped_lock lock(loop->error_mutex);
+            if (!loop->error || i < loop->error_index) {
+                loop->error_index = i;
+                loop->error = std::current_exception();
+            }
+            loop->failed = true;
+        }
+    }
+    in_loop = nested;
+}
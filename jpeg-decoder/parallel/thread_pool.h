@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker threads kept alive between parallel stages of the decoder, so a stage
+// run for every scan or MCU row doesn't start threads of its own.
+class ThreadPool {
+public:
+    // The pool runs loops on the calling thread and |workers| more threads.
+    explicit ThreadPool(size_t workers);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool();
+
+    // Shared pool with a thread per hardware thread, started on first use.
+    static ThreadPool& Default();
+
+    // Calls |body(i)| for every i in [0, count) on up to |threads| threads (all of
+    // the pool by default), the calling one included. Once a call fails no more
+    // are started, and the error of the smallest failed index is rethrown.
+    // Loops started from different threads run one after another; a loop started
+    // from |body| runs on the thread that started it.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& body, size_t threads = 0);
+
+private:
+    struct Loop;
+
+    void Work();
+    static void Run(Loop* loop);
+
+    std::mutex loop_mutex_;  // held by the thread running a loop
+
+    std::mutex mutex_;
+    std::condition_variable loop_started_;
+    std::condition_variable loop_finished_;
+    Loop* loop_ = nullptr;
+    size_t free_slots_ = 0;  // workers that may still join |loop_|
+    size_t busy_ = 0;        // workers running |loop_|
+    bool stopped_ = false;
+
+    std::vector<std::thread> workers_;
+};
@@ -0,0 +1,133 @@
+// Thread count scaling of the decoder stages that run on ThreadPool::Default().
+// Not part of a build target, from this directory:
+//   g++ -std=c++20 -O2 -mavx2 -c ../color/color_avx2.cpp
+//   g++ -std=c++20 -O2 -I. -I../color -c thread_pool.cpp ../color/color.cpp ../stream/*.cpp
+//   g++ -std=c++20 -O2 -I. -c ../huffman/{bit_reader,huffman,restart_intervals}.cpp
+//   g++ -std=c++20 -O2 -pthread -I../color -I../huffman -I../stream thread_pool_benchmark.cpp *.o
+//   ./a.out [max threads] [width] [height]
+//
+// There's no full decoder yet, so both stages get synthetic data the size of a
+// |width| by |height| 4:2:0 image:
+// color:   ScanlineStream with fancy upsampling, fed MCU rows of constant samples.
+// restart: DecodeRestartIntervals over random entropy-coded data with a restart
+//          marker after every MCU row, every interval read 16 bits at a time.
+// Thread counts double up to the maximum, by default the hardware threads, which
+// is also all ThreadPool::Default() can use.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "restart_intervals.h"
+#include "scanline_stream.h"
+
+namespace {
+
+constexpr std::chrono::milliseconds kDuration{500};
+
+// Passes per second of |pass|.
+double Measure(const std::function<void()>& pass) {
+    size_t passes = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed{};
+    while (elapsed < kDuration) {
+        pass();
+        ++passes;
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    return passes / elapsed.count();
+}
+
+// Megapixels per second of color conversion.
+double MeasureColor(size_t threads, size_t width, size_t height) {
+    uint64_t checksum = 0;
+    auto passes = Measure([&] {
+        ScanlineStream stream(
+            width, height, ChromaSubsampling::H2V2, Upsampling::FANCY,
+            [&checksum](size_t, std::span<const uint8_t> rgb) { checksum += rgb[0]; }, threads);
+        auto mcu_rows = (height + stream.GetMcuRowHeight() - 1) / stream.GetMcuRowHeight();
+        for (size_t i = 0; i < mcu_rows; ++i) {
+            auto row = stream.GetNextMcuRow();
+            std::memset(row.y, i, stream.GetMcuRowHeight() * row.y_stride);
+            std::memset(row.cb, 128 + i, 8 * row.chroma_stride);
+            std::memset(row.cr, 128 - i, 8 * row.chroma_stride);
+            stream.CommitMcuRow();
+        }
+    });
+    if (checksum == 1) {
+        std::abort();
+    }
+    return passes * width * height / 1e6;
+}
+
+// Random bytes with 0xFF stuffed and an RSTn marker after every |interval|
+// bytes. Returns the scan and stores the count of its intervals in |intervals|.
+std::vector<uint8_t> MakeScan(size_t bytes, size_t interval, size_t* intervals) {
+    std::mt19937 rng(1);
+    std::vector<uint8_t> scan;
+    *intervals = (bytes + interval - 1) / interval;
+    for (size_t i = 0; i < *intervals; ++i) {
+        if (i > 0) {
+            scan.push_back(0xFF);
+            scan.push_back(0xD0 + (i - 1) % 8);
+        }
+        for (size_t j = 0; j < interval; ++j) {
+            scan.push_back(rng());
+            if (scan.back() == 0xFF) {
+                scan.push_back(0);
+            }
+        }
+    }
+    return scan;
+}
+
+// Megabytes of entropy-coded data per second.
+double MeasureRestart(size_t threads, const std::vector<uint8_t>& scan, size_t intervals,
+                      size_t interval) {
+    std::vector<uint64_t> sums(intervals);
+    auto passes = Measure([&] {
+        DecodeRestartIntervals(
+            scan,
+            [&sums, interval](size_t index, BitReader* reader) {
+                uint64_t sum = 0;
+                for (size_t i = 0; i < interval / 2; ++i) {
+                    sum += reader->Read(16);
+                }
+                sums[index] = sum;
+            },
+            threads);
+    });
+    return passes * scan.size() / 1e6;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    auto hardware_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    auto max_threads = argc > 1 ? std::atoi(argv[1]) : hardware_threads;
+    auto width = argc > 2 ? std::atoi(argv[2]) : 3840;
+    auto height = argc > 3 ? std::atoi(argv[3]) : 2160;
+    if (max_threads < 1 || width < 16 || height < 16) {
+        std::fprintf(stderr, "usage: %s [max threads] [width >= 16] [height >= 16]\n", argv[0]);
+        return 1;
+    }
+
+    // A byte of entropy-coded data per pixel, an MCU row per interval.
+    size_t interval = 16 * width;
+    size_t intervals = 0;
+    auto scan = MakeScan(static_cast<size_t>(width) * height, interval, &intervals);
+
+    std::printf("%dx%d, %zu restart intervals\n", width, height, intervals);
+    std::printf("%8s %12s %12s\n", "threads", "color MP/s", "restart MB/s");
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        std::printf("%8d %12.1f %12.1f\n", threads, MeasureColor(threads, width, height),
+                    MeasureRestart(threads, scan, intervals, interval));
+    }
+}
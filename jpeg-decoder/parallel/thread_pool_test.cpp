@@ -0,0 +1,118 @@
+// ThreadPool::ParallelFor. Not part of a build target, from this directory:
+//   g++ -std=c++20 -O2 -pthread thread_pool_test.cpp thread_pool.cpp
+//
+// Every index has to run exactly once on at most the requested number of
+// threads, the error of the smallest failed index has to be rethrown, nested
+// loops have to run on the thread that started them, and loops started from
+// several threads at once have to run to completion.
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "thread_pool.h"
+
+namespace {
+
+void Check(bool condition, const char* what) {
+    if (!condition) {
+        std::fprintf(stderr, "failed: %s\n", what);
+        std::exit(1);
+    }
+}
+
+void CheckCoverage(ThreadPool* pool) {
+    for (size_t count = 0; count <= 40; ++count) {
+        for (size_t threads = 0; threads <= 4; ++threads) {
+            std::vector<std::atomic<int>> calls(count);
+            std::mutex mutex;
+            std::set<std::thread::id> ids;
+            pool->ParallelFor(
+                count,
+                [&](size_t i) {
+                    ++calls[i];
+                    std::scoped_lock lock(mutex);
+                    ids.insert(std::this_thread::get_id());
+                },
+                threads);
+            for (const auto& call : calls) {
+                Check(call == 1, "every index runs once");
+            }
+            Check(threads == 0 || ids.size() <= threads, "at most |threads| threads");
+        }
+    }
+}
+
+void CheckErrors(ThreadPool* pool) {
+    for (int round = 0; round < 200; ++round) {
+        // Every index from 13 on that ends in 3 fails, the later ones often first.
+        std::string error;
+        try {
+            pool->ParallelFor(100, [](size_t i) {
+                if (i % 10 == 3 && i >= 13) {
+                    throw std::runtime_error(std::to_string(i));
+                }
+            });
+        } catch (const std::runtime_error& e) {
+            error = e.what();
+        }
+        Check(error == "13", "error of the smallest failed index");
+    }
+
+    std::atomic<int> calls = 0;
+    pool->ParallelFor(50, [&calls](size_t) { ++calls; });
+    Check(calls == 50, "pool runs loops after an error");
+}
+
+void CheckNested(ThreadPool* pool) {
+    std::atomic<int> calls = 0;
+    pool->ParallelFor(8, [&](size_t) {
+        auto outer = std::this_thread::get_id();
+        pool->ParallelFor(8, [&](size_t) {
+            Check(std::this_thread::get_id() == outer, "nested loop runs on its thread");
+            ++calls;
+        });
+    });
+    Check(calls == 64, "nested loops run every index");
+}
+
+void CheckConcurrentCallers(ThreadPool* pool) {
+    std::atomic<int> calls = 0;
+    std::vector<std::thread> callers;
+    for (int i = 0; i < 4; ++i) {
+        callers.emplace_back([&] {
+            for (int round = 0; round < 50; ++round) {
+                pool->ParallelFor(8, [&](size_t) {
+                    pool->ParallelFor(8, [&calls](size_t) { ++calls; });
+                });
+            }
+        });
+    }
+    for (auto& caller : callers) {
+        caller.join();
+    }
+    Check(calls == 4 * 50 * 64, "loops of concurrent callers run every index");
+}
+
+}  // namespace
+
+int main() {
+    ThreadPool pool(7);
+    for (auto* tested : {&pool, &ThreadPool::Default()}) {
+        CheckCoverage(tested);
+        CheckErrors(tested);
+        CheckNested(tested);
+        CheckConcurrentCallers(tested);
+    }
+
+    ThreadPool empty(0);
+    CheckCoverage(&empty);
+    CheckErrors(&empty);
+    std::puts("ok");
+}
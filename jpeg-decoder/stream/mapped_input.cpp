@@ -0,0 +1,52 @@
+#include "mapped_input.h"
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedInput::MappedInput(const std::string& path) {
+    auto fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), path);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        auto error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(), path);
+    }
+    size_ = st.st_size;
+
+    if (size_ != 0) {
+        auto data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            auto error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), path);
+        }
+        madvise(data, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const uint8_t*>(data);
+    }
+    close(fd);
+}
+
+void MappedInput::Release(size_t offset) {
+    static const size_t kPageSize = sysconf(_SC_PAGESIZE);
+
+    // Only whole pages, the one holding |offset| may still be read.
+    auto end = std::min(offset, size_) / kPageSize * kPageSize;
+    if (end > released_) {
+        madvise(const_cast<uint8_t*>(data_) + released_, end - released_, MADV_DONTNEED);
+        released_ = end;
+    }
+}
+
+MappedInput::~MappedInput() {
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+}
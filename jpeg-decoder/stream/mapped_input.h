@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+// Read-only memory mapping of a whole JPEG file. Pages are loaded as the decoder
+// reads them, and the ones it is done with can be unmapped from the process.
+// The file is opened and mapped the same way as MappedFile of the scheme task;
+// tasks are built on their own, so the code is repeated rather than shared.
+class MappedInput {
+public:
+    explicit MappedInput(const std::string& path);
+
+    MappedInput(const MappedInput&) = delete;
+    MappedInput& operator=(const MappedInput&) = delete;
+
+    std::span<const uint8_t> GetData() const {
+        return {data_, size_};
+    }
+
+    // Drops the pages before |offset| from the mapping, so they no longer count
+    // towards the resident size of the process. The pages are clean file pages,
+    // so they stay in the page cache until the kernel evicts them; memory use of
+    // the system isn't bounded by this. Dropped pages are read again if accessed.
+    void Release(size_t offset);
+
+    ~MappedInput();
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    size_t released_ = 0;
+};
@@ -0,0 +1,120 @@
+#include "scanline_stream.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include "thread_pool.h"
+
+namespace {
+
+constexpr size_t kBlockSize = 8;
+
+// Rows of a chroma buffer: the context row above, the MCU row and the context
+// row below.
+constexpr size_t kChromaRows = kBlockSize + 2;
+
+// Scanlines converted by one task when conversion is split between threads,
+// a whole chroma row for 4:2:0.
+constexpr size_t kRowsPerTask = 2;
+
+}  // namespace
+
+ScanlineStream::ScanlineStream(size_t width, size_t height, ChromaSubsampling subsampling,
+                               Upsampling upsampling, Callback callback, size_t threads)
+    : width_(width),
+      height_(height),
+      subsampling_(subsampling),
+      upsampling_(upsampling),
+      callback_(std::move(callback)),
+      threads_(threads) {
+    if (width == 0 || height == 0) {
+        throw std::invalid_argument("bad");
+    }
+    size_t horizontal = subsampling == ChromaSubsampling::H1V1 ? 1 : 2;
+    vertical_ = subsampling == ChromaSubsampling::H2V2 ? 2 : 1;
+
+    mcu_height_ = kBlockSize * vertical_;
+    mcu_rows_ = (height + mcu_height_ - 1) / mcu_height_;
+    auto mcus = (width + kBlockSize * horizontal - 1) / (kBlockSize * horizontal);
+    y_stride_ = mcus * kBlockSize * horizontal;
+    chroma_stride_ = mcus * kBlockSize;
+
+    for (auto& slot : slots_) {
+        slot.y.resize((vertical_ + mcu_height_) * y_stride_);
+        slot.cb.resize(kChromaRows * chroma_stride_);
+        slot.cr.resize(kChromaRows * chroma_stride_);
+    }
+    rgb_.resize(mcu_height_ * width * 3);
+}
+
+ScanlineStream::McuRow ScanlineStream::GetNextMcuRow() {
+    if (committed_ == mcu_rows_) {
+        throw std::invalid_argument("bad");
+    }
+    auto& slot = slots_[committed_ % 2];
+    return {.y = slot.y.data() + vertical_ * y_stride_,
+            .cb = slot.cb.data() + chroma_stride_,
+            .cr = slot.cr.data() + chroma_stride_,
+            .y_stride = y_stride_,
+            .chroma_stride = chroma_stride_};
+}
+
+void ScanlineStream::CommitMcuRow() {
+    if (committed_ == mcu_rows_) {
+        throw std::invalid_argument("bad");
+    }
+    auto mcu_row = committed_++;
+    auto& current = slots_[mcu_row % 2];
+
+    // Context rows past the image edges repeat the edge rows.
+    if (mcu_row == 0) {
+        CopyChromaRow(current, 1, &current, 0);
+    } else {
+        auto& previous = slots_[(mcu_row - 1) % 2];
+        CopyChromaRow(current, 1, &previous, kChromaRows - 1);
+        CopyChromaRow(previous, kBlockSize, &current, 0);
+        Emit(previous, mcu_row - 1);
+    }
+
+    if (committed_ == mcu_rows_) {
+        auto rows = height_ - mcu_row * mcu_height_;
+        auto chroma_rows = (rows + vertical_ - 1) / vertical_;
+        CopyChromaRow(current, chroma_rows, &current, chroma_rows + 1);
+        Emit(current, mcu_row);
+    }
+}
+
+void ScanlineStream::CopyChromaRow(const Slot& from, size_t from_row, Slot* to, size_t to_row) {
+    std::memcpy(to->cb.data() + to_row * chroma_stride_, from.cb.data() + from_row * chroma_stride_,
+                chroma_stride_);
+    std::memcpy(to->cr.data() + to_row * chroma_stride_, from.cr.data() + from_row * chroma_stride_,
+                chroma_stride_);
+}
+
+void ScanlineStream::Emit(const Slot& slot, size_t mcu_row) {
+    auto first = mcu_row * mcu_height_;
+    auto rows = std::min(mcu_height_, height_ - first);
+    auto convert = [&](size_t row, size_t count) {
+        ConvertRows(subsampling_, upsampling_, {slot.y.data(), y_stride_, vertical_ + mcu_height_},
+                    {slot.cb.data(), chroma_stride_, kChromaRows},
+                    {slot.cr.data(), chroma_stride_, kChromaRows}, width_, vertical_ + row, count,
+                    rgb_.data() + row * width_ * 3, width_ * 3);
+    };
+    if (threads_ == 1) {
+        convert(0, rows);
+    } else {
+        auto tasks = (rows + kRowsPerTask - 1) / kRowsPerTask;
+        ThreadPool::Default().ParallelFor(
+            tasks,
+            [&](size_t task) {
+                auto row = task * kRowsPerTask;
+                convert(row, std::min(kRowsPerTask, rows - row));
+            },
+            threads_);
+    }
+
+    std::span<const uint8_t> rgb(rgb_);
+    for (size_t row = 0; row < rows; ++row) {
+        callback_(first + row, rgb.subspan(row * width_ * 3, width_ * 3));
+    }
+}
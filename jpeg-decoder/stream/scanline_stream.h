@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include "color.h"
+
+// Turns decoded MCU rows into RGB scanlines as soon as they are complete. Samples
+// go into a ring of two reusable MCU rows: the one being decoded and the one
+// waiting for the first chroma row of the next MCU row, which fancy upsampling
+// needs. So memory is proportional to the image width, not to its size.
+// Color conversion of an MCU row may be split between |threads| threads of
+// ThreadPool::Default(); scanlines are still emitted in order on the calling one.
+class ScanlineStream {
+public:
+    // Called for every scanline in order with |width| RGB pixels.
+    using Callback = std::function<void(size_t row, std::span<const uint8_t> rgb)>;
+
+    ScanlineStream(size_t width, size_t height, ChromaSubsampling subsampling,
+                   Upsampling upsampling, Callback callback, size_t threads = 1);
+
+    ScanlineStream(const ScanlineStream&) = delete;
+    ScanlineStream& operator=(const ScanlineStream&) = delete;
+
+    // Buffers for the samples of the next MCU row, padded to whole MCUs:
+    // GetMcuRowHeight() rows of luma and 8 rows of each chroma component.
+    struct McuRow {
+        uint8_t* y;
+        uint8_t* cb;
+        uint8_t* cr;
+        size_t y_stride;
+        size_t chroma_stride;
+    };
+    McuRow GetNextMcuRow();
+
+    // Emits the scanlines completed by the MCU row written to GetNextMcuRow.
+    // After the last MCU row all scanlines are emitted.
+    void CommitMcuRow();
+
+    size_t GetMcuRowHeight() const {
+        return mcu_height_;
+    }
+
+private:
+    // The luma buffer starts with |vertical_| unused rows, and the chroma buffers
+    // hold a context row above and below the MCU row. Then row numbers of both
+    // match the subsampling, as ConvertRows expects.
+    struct Slot {
+        std::vector<uint8_t> y;
+        std::vector<uint8_t> cb;
+        std::vector<uint8_t> cr;
+    };
+
+    void CopyChromaRow(const Slot& from, size_t from_row, Slot* to, size_t to_row);
+    void Emit(const Slot& slot, size_t mcu_row);
+
+    size_t width_;
+    size_t height_;
+    ChromaSubsampling subsampling_;
+    Upsampling upsampling_;
+    Callback callback_;
+    size_t threads_;
+
+    size_t vertical_;
+    size_t mcu_height_;
+    size_t mcu_rows_;
+    size_t y_stride_;
+    size_t chroma_stride_;
+
+    std::array<Slot, 2> slots_;
+    size_t committed_ = 0;
+    std::vector<uint8_t> rgb_;
+};
@@ -0,0 +1,2 @@
+add_library(decoder_stream mapped_input.cpp scanline_stream.cpp)
+target_link_libraries(decoder_stream PUBLIC decoder_color decoder_parallel)
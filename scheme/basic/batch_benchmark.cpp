@@ -0,0 +1,74 @@
+// Thread count scaling of Interpreter::RunBatch. Not part of a build target, from
+// this directory:
+//   g++ -std=c++20 -O2 -pthread -I. batch_benchmark.cpp $(ls *.cpp | grep -v '_benchmark\|_test')
+//   ./batch_benchmark [max threads] [programs]
+//
+// A batch of small independent programs, arithmetic and list ones in turn, runs
+// in both modes, and in bytecode mode once more with a ProgramCache shared by all
+// threads that already holds every program. Thread counts double up to the
+// maximum, which may exceed the hardware threads to oversubscribe the batch.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "program_cache.h"
+#include "scheme.h"
+
+namespace {
+
+std::vector<std::string> MakePrograms(int count) {
+    std::vector<std::string> programs;
+    for (int i = 0; i < count; ++i) {
+        auto n = std::to_string(i);
+        if (i % 2 == 0) {
+            programs.push_back("(+ " + n + " (* (- " + n + " 3) (+ 1 2) (max 4 " + n +
+                               ")) (min (* 2 " + n + ") 50 (- 100 " + n + ")))");
+        } else {
+            programs.push_back("(car (cdr (list-tail (list " + n + " 1 2 3 4 5 6 7 " + n + ") " +
+                               std::to_string(i % 8) + ")))");
+        }
+    }
+    return programs;
+}
+
+// Thousands of programs per second.
+double Run(Interpreter* interpreter, const std::vector<std::string>& programs, int threads) {
+    auto start = std::chrono::steady_clock::now();
+    auto results = interpreter->RunBatch(programs, threads);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (results.size() != programs.size()) {
+        std::abort();
+    }
+    return programs.size() / elapsed.count() / 1e3;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    auto hardware_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    auto max_threads = argc > 1 ? std::atoi(argv[1]) : 2 * hardware_threads;
+    auto count = argc > 2 ? std::atoi(argv[2]) : 100000;
+    if (max_threads < 1 || count < 1) {
+        std::fprintf(stderr, "usage: %s [max threads] [programs]\n", argv[0]);
+        return 1;
+    }
+
+    auto programs = MakePrograms(count);
+    Interpreter tree_walk(EvaluationMode::TREE_WALK);
+    Interpreter bytecode(EvaluationMode::BYTECODE);
+    ProgramCache cache(count);
+    Interpreter cached(EvaluationMode::BYTECODE, &cache);
+    cached.RunBatch(programs);
+
+    std::printf("%d programs, thousands of programs/s\n", count);
+    std::printf("%8s %12s %12s %12s\n", "threads", "tree-walk", "bytecode", "cached");
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        std::printf("%8d %12.1f %12.1f %12.1f\n", threads, Run(&tree_walk, programs, threads),
+                    Run(&bytecode, programs, threads), Run(&cached, programs, threads));
+    }
+}
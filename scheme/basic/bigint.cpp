@@ -0,0 +1,310 @@
+#include "bigint.h"
+#include <algorithm>
+#include <bit>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+using Limbs = std::vector<uint32_t>;
+using LimbSpan = std::span<const uint32_t>;
+
+// Operands shorter than this many limbs are multiplied by the schoolbook method.
+constexpr size_t kKaratsubaThreshold = 32;
+
+LimbSpan Trim(LimbSpan limbs) {
+    while (!limbs.empty() && limbs.back() == 0) {
+        limbs = limbs.first(limbs.size() - 1);
+    }
+    return limbs;
+}
+
+void Trim(Limbs* limbs) {
+    while (!limbs->empty() && limbs->back() == 0) {
+        limbs->pop_back();
+    }
+}
+
+int CompareMagnitude(LimbSpan lhs, LimbSpan rhs) {
+    if (lhs.size() != rhs.size()) {
+        return lhs.size() < rhs.size() ? -1 : 1;
+    }
+    for (size_t i = lhs.size(); i-- > 0;) {
+        if (lhs[i] != rhs[i]) {
+            return lhs[i] < rhs[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+Limbs AddMagnitude(LimbSpan lhs, LimbSpan rhs) {
+    if (lhs.size() < rhs.size()) {
+        std::swap(lhs, rhs);
+    }
+    Limbs ans(lhs.size() + 1);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        carry += uint64_t{lhs[i]} + (i < rhs.size() ? rhs[i] : 0);
+        ans[i] = static_cast<uint32_t>(carry);
+        carry >>= 32;
+    }
+    ans.back() = static_cast<uint32_t>(carry);
+    Trim(&ans);
+    return ans;
+}
+
+// |lhs| must not be less than |rhs|.
+Limbs SubMagnitude(LimbSpan lhs, LimbSpan rhs) {
+    Limbs ans(lhs.size());
+    int64_t borrow = 0;
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        int64_t diff = int64_t{lhs[i]} - (i < rhs.size() ? rhs[i] : 0) - borrow;
+        borrow = diff < 0;
+        ans[i] = static_cast<uint32_t>(diff);
+    }
+    Trim(&ans);
+    return ans;
+}
+
+// |*acc| += |value| << (32 * |shift|), |*acc| must be long enough.
+void AddShifted(Limbs* acc, LimbSpan value, size_t shift) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < value.size() || carry; ++i) {
+        carry += uint64_t{(*acc)[i + shift]} + (i < value.size() ? value[i] : 0);
+        (*acc)[i + shift] = static_cast<uint32_t>(carry);
+        carry >>= 32;
+    }
+}
+
+Limbs MulSchoolbook(LimbSpan lhs, LimbSpan rhs) {
+    Limbs ans(lhs.size() + rhs.size());
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < rhs.size(); ++j) {
+            carry += uint64_t{lhs[i]} * rhs[j] + ans[i + j];
+            ans[i + j] = static_cast<uint32_t>(carry);
+            carry >>= 32;
+        }
+        ans[i + rhs.size()] = static_cast<uint32_t>(carry);
+    }
+    Trim(&ans);
+    return ans;
+}
+
+// lhs * rhs = z2 * B^2h + ((l0 + l1)(r0 + r1) - z2 - z0) * B^h + z0, with B^h
+// splitting both operands in halves and z0 = l0 * r0, z2 = l1 * r1.
+Limbs MulKaratsuba(LimbSpan lhs, LimbSpan rhs) {
+    if (std::min(lhs.size(), rhs.size()) < kKaratsubaThreshold) {
+        return MulSchoolbook(lhs, rhs);
+    }
+
+    auto half = std::max(lhs.size(), rhs.size()) / 2;
+    auto split = [half](LimbSpan value) -> std::pair<LimbSpan, LimbSpan> {
+        if (value.size() <= half) {
+            return {value, {}};
+        }
+        return {Trim(value.first(half)), value.subspan(half)};
+    };
+    auto [l0, l1] = split(lhs);
+    auto [r0, r1] = split(rhs);
+
+    auto z0 = MulKaratsuba(l0, r0);
+    auto z2 = MulKaratsuba(l1, r1);
+    auto z1 = MulKaratsuba(AddMagnitude(l0, l1), AddMagnitude(r0, r1));
+    z1 = SubMagnitude(SubMagnitude(z1, z0), z2);
+
+    Limbs ans(lhs.size() + rhs.size() + 1);
+    AddShifted(&ans, z0, 0);
+    AddShifted(&ans, z1, half);
+    AddShifted(&ans, z2, 2 * half);
+    Trim(&ans);
+    return ans;
+}
+
+// Divides |*value| in place and returns the remainder.
+uint32_t DivSmall(Limbs* value, uint32_t divisor) {
+    uint64_t rem = 0;
+    for (size_t i = value->size(); i-- > 0;) {
+        auto cur = (rem << 32) | (*value)[i];
+        (*value)[i] = static_cast<uint32_t>(cur / divisor);
+        rem = cur % divisor;
+    }
+    Trim(value);
+    return static_cast<uint32_t>(rem);
+}
+
+// Knuth's algorithm D, |rhs| must be non-zero.
+Limbs DivMagnitude(LimbSpan lhs, LimbSpan rhs) {
+    if (CompareMagnitude(lhs, rhs) < 0) {
+        return {};
+    }
+    if (rhs.size() == 1) {
+        Limbs ans(lhs.begin(), lhs.end());
+        DivSmall(&ans, rhs[0]);
+        return ans;
+    }
+
+    // Normalize so that the top limb of the divisor has its high bit set.
+    auto n = rhs.size();
+    auto m = lhs.size();
+    auto shift = std::countl_zero(rhs.back());
+    auto shifted = [shift](LimbSpan value, size_t i) {
+        auto high = i < value.size() ? value[i] << shift : 0;
+        auto low = shift != 0 && i > 0 ? value[i - 1] >> (32 - shift) : 0;
+        return high | low;
+    };
+    Limbs v(n);
+    Limbs u(m + 1);
+    for (size_t i = 0; i < n; ++i) {
+        v[i] = shifted(rhs, i);
+    }
+    for (size_t i = 0; i <= m; ++i) {
+        u[i] = shifted(lhs, i);
+    }
+
+    Limbs ans(m - n + 1);
+    for (size_t j = m - n + 1; j-- > 0;) {
+        auto top = (uint64_t{u[j + n]} << 32) | u[j + n - 1];
+        auto qhat = top / v[n - 1];
+        auto rhat = top % v[n - 1];
+        while (qhat >> 32 || qhat * v[n - 2] > ((rhat << 32) | u[j + n - 2])) {
+            --qhat;
+            rhat += v[n - 1];
+            if (rhat >> 32) {
+                break;
+            }
+        }
+
+        uint64_t carry = 0;
+        int64_t borrow = 0;
+        for (size_t i = 0; i < n; ++i) {
+            auto product = qhat * v[i] + carry;
+            carry = product >> 32;
+            auto diff = int64_t{u[i + j]} - static_cast<uint32_t>(product) - borrow;
+            u[i + j] = static_cast<uint32_t>(diff);
+            borrow = diff < 0;
+        }
+        auto diff = int64_t{u[j + n]} - static_cast<int64_t>(carry) - borrow;
+        u[j + n] = static_cast<uint32_t>(diff);
+
+        // qhat was one too big, add the divisor back.
+        if (diff < 0) {
+            --qhat;
+            carry = 0;
+            for (size_t i = 0; i < n; ++i) {
+                carry += uint64_t{u[i + j]} + v[i];
+                u[i + j] = static_cast<uint32_t>(carry);
+                carry >>= 32;
+            }
+            u[j + n] += static_cast<uint32_t>(carry);
+        }
+        ans[j] = static_cast<uint32_t>(qhat);
+    }
+    Trim(&ans);
+    return ans;
+}
+
+}  // namespace
+
+BigInteger::BigInteger(int64_t value) : negative_(value < 0) {
+    auto magnitude = negative_ ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    while (magnitude != 0) {
+        limbs_.push_back(static_cast<uint32_t>(magnitude));
+        magnitude >>= 32;
+    }
+}
+
+BigInteger::BigInteger(bool negative, std::vector<uint32_t> limbs)
+    : negative_(negative), limbs_(std::move(limbs)) {
+    Trim(&limbs_);
+    if (limbs_.empty()) {
+        negative_ = false;
+    }
+}
+
+bool BigInteger::FitsInt64() const {
+    if (limbs_.size() > 2) {
+        return false;
+    }
+    uint64_t magnitude = 0;
+    for (size_t i = limbs_.size(); i-- > 0;) {
+        magnitude = (magnitude << 32) | limbs_[i];
+    }
+    return magnitude <= (uint64_t{1} << 63) - !negative_;
+}
+
+int64_t BigInteger::ToInt64() const {
+    uint64_t magnitude = 0;
+    for (size_t i = limbs_.size(); i-- > 0;) {
+        magnitude = (magnitude << 32) | limbs_[i];
+    }
+    return static_cast<int64_t>(negative_ ? 0 - magnitude : magnitude);
+}
+
+std::string BigInteger::ToString() const {
+    if (IsZero()) {
+        return "0";
+    }
+
+    // Peel off 9 decimal digits per division.
+    constexpr uint32_t kChunk = 1'000'000'000;
+    std::string ans;
+    auto magnitude = limbs_;
+    while (!magnitude.empty()) {
+        auto chunk = DivSmall(&magnitude, kChunk);
+        for (int i = 0; i < 9 && (chunk != 0 || !magnitude.empty()); ++i) {
+            ans.push_back(static_cast<char>('0' + chunk % 10));
+            chunk /= 10;
+        }
+    }
+    if (negative_) {
+        ans.push_back('-');
+    }
+    std::ranges::reverse(ans);
+    return ans;
+}
+
+BigInteger BigInteger::Abs() const {
+    return {false, limbs_};
+}
+
+BigInteger BigInteger::operator-() const {
+    return {!negative_, limbs_};
+}
+
+BigInteger operator+(const BigInteger& lhs, const BigInteger& rhs) {
+    if (lhs.negative_ == rhs.negative_) {
+        return {lhs.negative_, AddMagnitude(lhs.limbs_, rhs.limbs_)};
+    }
+    if (CompareMagnitude(lhs.limbs_, rhs.limbs_) >= 0) {
+        return {lhs.negative_, SubMagnitude(lhs.limbs_, rhs.limbs_)};
+    }
+    return {rhs.negative_, SubMagnitude(rhs.limbs_, lhs.limbs_)};
+}
+
+BigInteger operator-(const BigInteger& lhs, const BigInteger& rhs) {
+    return lhs + -rhs;
+}
+
+BigInteger operator*(const BigInteger& lhs, const BigInteger& rhs) {
+    return {lhs.negative_ != rhs.negative_, MulKaratsuba(lhs.limbs_, rhs.limbs_)};
+}
+
+BigInteger operator/(const BigInteger& lhs, const BigInteger& rhs) {
+    if (rhs.IsZero()) {
+        throw std::domain_error("Division by zero");
+    }
+    return {lhs.negative_ != rhs.negative_, DivMagnitude(lhs.limbs_, rhs.limbs_)};
+}
+
+std::strong_ordering operator<=>(const BigInteger& lhs, const BigInteger& rhs) {
+    if (lhs.negative_ != rhs.negative_) {
+        return lhs.negative_ ? std::strong_ordering::less : std::strong_ordering::greater;
+    }
+    auto cmp = CompareMagnitude(lhs.limbs_, rhs.limbs_);
+    if (lhs.negative_) {
+        cmp = -cmp;
+    }
+    return cmp <=> 0;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <compare>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Arbitrary-precision integer in sign-magnitude form with 32-bit limbs.
+// Large products use Karatsuba multiplication, division truncates toward zero.
+class BigInteger {
+public:
+    BigInteger() = default;
+    BigInteger(int64_t value);
+
+    bool IsZero() const {
+        return limbs_.empty();
+    }
+
+    bool FitsInt64() const;
+    int64_t ToInt64() const;
+
+    std::string ToString() const;
+
+    BigInteger Abs() const;
+    BigInteger operator-() const;
+
+    friend BigInteger operator+(const BigInteger& lhs, const BigInteger& rhs);
+    friend BigInteger operator-(const BigInteger& lhs, const BigInteger& rhs);
+    friend BigInteger operator*(const BigInteger& lhs, const BigInteger& rhs);
+    // Throws std::domain_error if |rhs| is zero.
+    friend BigInteger operator/(const BigInteger& lhs, const BigInteger& rhs);
+
+    friend std::strong_ordering operator<=>(const BigInteger& lhs, const BigInteger& rhs);
+    friend bool operator==(const BigInteger& lhs, const BigInteger& rhs) = default;
+
+private:
+    BigInteger(bool negative, std::vector<uint32_t> limbs);
+
+    bool negative_ = false;
+    std::vector<uint32_t> limbs_;  // little-endian magnitude without leading zeros
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "source_position.h"
+#include "value.h"
+
+enum class Opcode : uint8_t {
+    PUSH_CONSTANT,         // push constants[operand]
+    APPLY,                 // pop operand evaluated args, push function->Apply(args)
+    CALL,                  // push function->Evaluate(constants[operand]) (tree-walk fallback)
+    JUMP_IF_TRUE_OR_POP,   // keep top and jump to operand if it is true, otherwise pop it
+    JUMP_IF_FALSE_OR_POP,  // keep top and jump to operand if it is false, otherwise pop it
+    RAISE,                 // throw RuntimeError(messages[operand])
+};
+
+struct Instruction {
+    Opcode opcode;
+    uint32_t operand = 0;
+    Function* function = nullptr;
+#ifdef SCHEME_PROFILING
+    SourcePosition position{};  // of the call, for APPLY and CALL
+#endif
+};
+
+struct Program {
+    std::vector<Instruction> code;
+    std::vector<Value> constants;
+    std::vector<std::string> messages;
+};
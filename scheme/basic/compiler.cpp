@@ -0,0 +1,126 @@
+#include "compiler.h"
+#include <cstdint>
+#include <utility>
+#include "error.h"
+
+template <class... Ts>
+struct Overloaded : Ts... {
+    using Ts::operator()...;
+};
+
+Program Compiler::Compile(const Handle<Object>& ast) {
+    program_ = {};
+    labels_.clear();
+    jumps_.clear();
+
+    work_.push_back(Evaluate{ast});
+    while (!work_.empty()) {
+        auto task = std::move(work_.back());
+        work_.pop_back();
+        std::visit(Overloaded{[this](Evaluate& evaluate) { Expand(evaluate.obj); },
+                              [this](Instruction& instruction) {
+                                  if (instruction.opcode == Opcode::JUMP_IF_TRUE_OR_POP ||
+                                      instruction.opcode == Opcode::JUMP_IF_FALSE_OR_POP) {
+                                      jumps_.push_back(program_.code.size());
+                                  }
+                                  program_.code.push_back(instruction);
+                              },
+                              [this](Label& label) {
+                                  labels_[label.id] = static_cast<uint32_t>(program_.code.size());
+                              }},
+                   task);
+    }
+
+    for (auto jump : jumps_) {
+        program_.code[jump].operand = labels_[program_.code[jump].operand];
+    }
+    return std::move(program_);
+}
+
+void Compiler::Expand(const Handle<Object>& obj) {
+    pending_.clear();
+
+    if (!obj) {
+        EmitRaise("Empty list is not evaluatable!");
+    } else if (auto cell = As<Cell>(obj)) {
+        auto symbol = As<Symbol>(cell->GetFirst());
+        auto function = symbol ? symbol->GetFunction() : nullptr;
+        if (function) {
+#ifdef SCHEME_PROFILING
+            position_ = cell->GetPosition();
+#endif
+            CompileCall(function, cell->GetSecond());
+        } else {
+            EmitRaise("Lists (without functors) are not evaluatable!");
+        }
+    } else if (auto symbol = As<Symbol>(obj); symbol && symbol->GetFunction()) {
+        CompileCall(symbol->GetFunction(), nullptr);
+    } else {
+        EmitConstant(obj);
+    }
+
+    work_.insert(work_.end(), std::make_move_iterator(pending_.rbegin()),
+                 std::make_move_iterator(pending_.rend()));
+}
+
+void Compiler::EmitEvaluate(Handle<Object> obj) {
+    pending_.push_back(Evaluate{std::move(obj)});
+}
+
+void Compiler::EmitConstant(Handle<Object> obj) {
+    program_.constants.emplace_back(std::move(obj));
+    pending_.push_back(
+        Instruction{Opcode::PUSH_CONSTANT, static_cast<uint32_t>(program_.constants.size() - 1)});
+}
+
+void Compiler::EmitApply(Function* function, size_t args) {
+    Instruction instruction{Opcode::APPLY, static_cast<uint32_t>(args), function};
+#ifdef SCHEME_PROFILING
+    instruction.position = position_;
+#endif
+    pending_.push_back(instruction);
+}
+
+void Compiler::EmitCall(Function* function, Handle<Object> ctx) {
+    program_.constants.emplace_back(std::move(ctx));
+    Instruction instruction{Opcode::CALL, static_cast<uint32_t>(program_.constants.size() - 1),
+                            function};
+#ifdef SCHEME_PROFILING
+    instruction.position = position_;
+#endif
+    pending_.push_back(instruction);
+}
+
+void Compiler::EmitRaise(std::string message) {
+    program_.messages.emplace_back(std::move(message));
+    pending_.push_back(
+        Instruction{Opcode::RAISE, static_cast<uint32_t>(program_.messages.size() - 1)});
+}
+
+size_t Compiler::NewLabel() {
+    labels_.push_back(0);
+    return labels_.size() - 1;
+}
+
+void Compiler::EmitJump(Opcode opcode, size_t label) {
+    pending_.push_back(Instruction{opcode, static_cast<uint32_t>(label)});
+}
+
+void Compiler::BindLabel(size_t label) {
+    pending_.push_back(Label{label});
+}
+
+void Compiler::CompileCall(Function* function, const Handle<Object>& ctx) {
+    // Arity and argument checks of builtins are static, so they are done here.
+    // A failed check must only fire if the call is actually reached at runtime.
+    try {
+        function->Compile(ctx, this);
+    } catch (const RuntimeError& error) {
+        pending_.clear();
+        EmitRaise(error.what());
+    }
+}
+
+Program Compile(const Handle<Object>& ast) {
+    return Compiler{}.Compile(ast);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "bytecode.h"
+#include "object.h"
+
+// Lowers a parsed AST into bytecode for Vm. Every builtin describes its own
+// lowering in Function::Compile using the Emit* methods below.
+//
+// Emit* calls made while a builtin is compiled are queued, and the evaluations
+// requested with EmitEvaluate are expanded later from an explicit work list, so
+// compiling deeply nested expressions doesn't consume native stack.
+class Compiler {
+public:
+    Program Compile(const Handle<Object>& ast);
+
+    // Emits code that leaves the value of |obj->Evaluate()| on the stack.
+    void EmitEvaluate(Handle<Object> obj);
+
+    // Emits code that leaves |obj| itself (not evaluated) on the stack.
+    void EmitConstant(Handle<Object> obj);
+
+    // Emits a call of |function| on |args| values taken from the stack.
+    void EmitApply(Function* function, size_t args);
+
+    // Emits a tree-walking call of |function| with the unevaluated |ctx|.
+    void EmitCall(Function* function, Handle<Object> ctx);
+
+    void EmitRaise(std::string message);
+
+    // Creates a label to be placed later with BindLabel.
+    size_t NewLabel();
+
+    // Emits a conditional jump to |label|.
+    void EmitJump(Opcode opcode, size_t label);
+
+    // Places |label| at the next emitted instruction.
+    void BindLabel(size_t label);
+
+private:
+    struct Evaluate {
+        Handle<Object> obj;
+    };
+    struct Label {
+        size_t id;
+    };
+    using Task = std::variant<Evaluate, Instruction, Label>;
+
+    void Expand(const Handle<Object>& obj);
+    void CompileCall(Function* function, const Handle<Object>& ctx);
+
+    Program program_;
+    std::vector<Task> work_;
+    std::vector<Task> pending_;
+    std::vector<uint32_t> labels_;
+    std::vector<size_t> jumps_;
+#ifdef SCHEME_PROFILING
+    SourcePosition position_;  // of the call being compiled
+#endif
+};
+
+Program Compile(const Handle<Object>& ast);
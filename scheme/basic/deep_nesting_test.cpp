@@ -0,0 +1,85 @@
+// Stress test of programs nested a million levels deep. Not part of a build
+// target, from this directory:
+//   g++ -std=c++20 -O2 -pthread -I. deep_nesting_test.cpp $(ls *.cpp | grep -v '_benchmark\|_test')
+//   ./deep_nesting_test [depth]
+//
+// Reading, optimizing, compiling, running and printing must not recurse once per
+// level, so none of this may overflow the stack. Only the bytecode mode is run;
+// the tree walker is the recursive reference. Prints the time of every program,
+// which has to stay linear in the depth.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "error.h"
+#include "optimizer.h"
+#include "scheme.h"
+
+namespace {
+
+void Check(bool condition, const char* what) {
+    if (!condition) {
+        std::fprintf(stderr, "failed: %s\n", what);
+        std::exit(1);
+    }
+}
+
+// |depth| calls (head ... (head ... leaf)).
+std::string Nest(const std::string& head, const std::string& leaf, int depth) {
+    std::string program;
+    for (int i = 0; i < depth; ++i) {
+        program += '(';
+        program += head;
+        program += ' ';
+    }
+    program += leaf;
+    program.append(depth, ')');
+    return program;
+}
+
+// Quoted list nested |depth| levels around |leaf|.
+std::string NestedList(const std::string& leaf, int depth) {
+    return "'" + std::string(depth, '(') + leaf + std::string(depth, ')');
+}
+
+void Run(Interpreter* interpreter, const char* name, const std::string& program,
+         const std::string& expected) {
+    auto start = std::chrono::steady_clock::now();
+    auto result = interpreter->Run(program);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("%-12s %10.1f ms\n", name, elapsed.count());
+    Check(result == expected, name);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    auto depth = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    if (depth < 1) {
+        std::fprintf(stderr, "usage: %s [depth]\n", argv[0]);
+        return 1;
+    }
+
+    Optimizer optimizer;
+    for (auto* optimizing : {static_cast<Optimizer*>(nullptr), &optimizer}) {
+        std::printf(optimizing ? "optimized\n" : "not optimized\n");
+        Interpreter interpreter(EvaluationMode::BYTECODE, nullptr, optimizing);
+        Run(&interpreter, "sum", Nest("+ 1", "1", depth), std::to_string(depth + 1));
+        Run(&interpreter, "and", Nest("and #t", "5", depth), "5");
+        Run(&interpreter, "max", Nest("max 2", "1", depth), "2");
+        Run(&interpreter, "car", Nest("car", NestedList("7", depth), depth), "7");
+        Run(&interpreter, "print", NestedList("7", depth),
+            std::string(depth, '(') + "7" + std::string(depth, ')'));
+
+        bool failed = false;
+        try {
+            interpreter.Run(Nest("+ 1", "(car)", depth));
+        } catch (const RuntimeError&) {
+            failed = true;
+        }
+        Check(failed, "error from the innermost level");
+    }
+    std::puts("ok");
+}
@@ -0,0 +1,34 @@
+#include "hash_cons.h"
+
+Handle<Number> HashConser::MakeNumber(int64_t value) {
+    std::scoped_lock lock(mutex_);
+    auto& number = numbers_[value];
+    if (!number) {
+        number = heap_.New<Number>(value);
+    }
+    return number;
+}
+
+Handle<Symbol> HashConser::MakeSymbol(std::string_view name) {
+    auto id = Intern(name);
+    std::scoped_lock lock(mutex_);
+    auto& symbol = symbols_[id];
+    if (!symbol) {
+        symbol = heap_.New<Symbol>(id);
+    }
+    return symbol;
+}
+
+Handle<Cell> HashConser::MakeCell(Handle<Object> first, Handle<Object> second) {
+    std::scoped_lock lock(mutex_);
+    auto& cell = cells_[{first.get(), second.get()}];
+    if (!cell) {
+        cell = heap_.New<Cell>(std::move(first), std::move(second));
+    }
+    return cell;
+}
+
+size_t HashConser::Size() const {
+    std::scoped_lock lock(mutex_);
+    return numbers_.size() + symbols_.size() + cells_.size();
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include "object.h"
+
+// Hash-consing table for the reader: structurally identical numbers, symbols
+// and cells are created once and shared. Data is immutable, so this is
+// invisible to evaluation, but repeated quoted data takes memory only once and
+// equal? on it reduces to a pointer check.
+//
+// Cells are keyed by the addresses of their (already shared) children, so a
+// lookup is O(1) regardless of the size of the structure. The objects live on a
+// heap of the table which is never collected, so everything stays alive as long
+// as the table does, and the table has to outlive whatever refers to them,
+// including programs cached from its data. Thread-safe. Shared cells are never
+// modified, so they carry no source position for the profiler.
+class HashConser {
+public:
+    Handle<Number> MakeNumber(int64_t value);
+    Handle<Symbol> MakeSymbol(std::string_view name);
+    Handle<Cell> MakeCell(Handle<Object> first, Handle<Object> second = nullptr);
+
+    // Amount of distinct objects in the table.
+    size_t Size() const;
+
+private:
+    struct PairHash {
+        size_t operator()(const std::pair<Object*, Object*>& pair) const {
+            auto first = std::hash<Object*>{}(pair.first);
+            return first ^ (std::hash<Object*>{}(pair.second) + 0x9e3779b97f4a7c15 +
+                            (first << 6) + (first >> 2));
+        }
+    };
+
+    mutable std::mutex mutex_;
+    Heap heap_;
+    std::unordered_map<int64_t, Handle<Number>> numbers_;
+    std::unordered_map<SymbolId, Handle<Symbol>> symbols_;
+    std::unordered_map<std::pair<Object*, Object*>, Handle<Cell>, PairHash> cells_;
+};
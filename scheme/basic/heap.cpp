@@ -0,0 +1,175 @@
+#include "heap.h"
+#include <algorithm>
+#include "object.h"
+
+Heap::Heap() {
+    for (size_t i = 0; i < classes_.size(); ++i) {
+        classes_[i].block_size = i * kGranule;
+    }
+}
+
+Heap::~Heap() {
+    for (auto& size_class : classes_) {
+        Retire(&size_class);
+        while (auto chunk = size_class.chunks) {
+            Sweep(chunk);
+            size_class.chunks = chunk->next;
+            ReleaseChunk(chunk);
+        }
+    }
+}
+
+Heap& Heap::Current() {
+    if (current_) {
+        return *current_;
+    }
+    thread_local Heap heap;
+    return heap;
+}
+
+void* Heap::NewChunk() {
+    {
+        std::scoped_lock lock(idle_mutex_);
+        if (idle_count_ > 0) {
+            return idle_[--idle_count_];
+        }
+    }
+    return ::operator new(kChunkSize, std::align_val_t{kChunkSize});
+}
+
+void Heap::ReleaseChunk(Chunk* chunk) {
+    chunk->~Chunk();
+    {
+        std::scoped_lock lock(idle_mutex_);
+        if (idle_count_ < kMaxIdleChunks) {
+            idle_[idle_count_++] = chunk;
+            return;
+        }
+    }
+    ::operator delete(chunk, std::align_val_t{kChunkSize});
+}
+
+void* Heap::Refill(SizeClass* size_class) {
+    Retire(size_class);
+    auto memory = NewChunk();
+    auto chunk = new (memory) Chunk{this, size_class->chunks, size_class->block_size, 0, {}};
+    size_class->chunks = chunk;
+    ++chunks_;
+
+    auto blocks = (kChunkSize - kHeaderSize) / size_class->block_size;
+    size_class->cur = GetBlocks(chunk) + size_class->block_size;
+    size_class->end = GetBlocks(chunk) + blocks * size_class->block_size;
+    return GetBlocks(chunk);
+}
+
+void Heap::Free(SizeClass* size_class, void* memory) {
+    size_class->free = new (memory) FreeBlock{&kFreeTag, size_class->free};
+    allocated_bytes_ -= size_class->block_size;
+}
+
+void Heap::Retire(SizeClass* size_class) {
+    if (size_class->chunks && size_class->cur) {
+        auto blocks = GetBlocks(size_class->chunks);
+        size_class->chunks->used =
+            static_cast<size_t>(size_class->cur - blocks) / size_class->block_size;
+    }
+}
+
+bool Heap::Mark(Object* object) {
+    if (!object) {
+        return false;
+    }
+    auto chunk = GetChunk(object);
+    if (chunk->heap != this) {
+        return false;
+    }
+    auto index = static_cast<size_t>(reinterpret_cast<std::byte*>(object) - GetBlocks(chunk)) /
+                 chunk->block_size;
+    if (chunk->marked[index]) {
+        return false;
+    }
+    chunk->marked[index] = true;
+    return true;
+}
+
+void Heap::Collect(std::span<Object* const> roots) {
+    for (auto root : roots) {
+        if (Mark(root)) {
+            mark_stack_.push_back(root);
+        }
+    }
+    while (!mark_stack_.empty()) {
+        auto object = mark_stack_.back();
+        mark_stack_.pop_back();
+        auto first = mark_stack_.size();
+        object->Trace(&mark_stack_);
+        // Keep only the children seen for the first time.
+        auto last = first;
+        for (auto i = first; i < mark_stack_.size(); ++i) {
+            if (Mark(mark_stack_[i])) {
+                mark_stack_[last++] = mark_stack_[i];
+            }
+        }
+        mark_stack_.resize(last);
+    }
+
+    size_t live = 0;
+    for (auto& size_class : classes_) {
+        Retire(&size_class);
+        size_class.free = nullptr;
+        for (auto link = &size_class.chunks; *link;) {
+            auto chunk = *link;
+            auto blocks = Sweep(chunk);
+            if (blocks > 0) {
+                live += blocks * size_class.block_size;
+                LinkFree(chunk, &size_class);
+                link = &chunk->next;
+                continue;
+            }
+            if (chunk == size_class.chunks) {
+                size_class.cur = size_class.end = nullptr;
+            }
+            *link = chunk->next;
+            ReleaseChunk(chunk);
+            --chunks_;
+        }
+    }
+
+    live_bytes_ = live;
+    allocated_bytes_ = 0;
+    next_collection_ = std::max(kMinCollection, live);
+    ++collections_;
+}
+
+size_t Heap::Sweep(Chunk* chunk) {
+    size_t live = 0;
+    for (size_t i = 0; i < chunk->used; ++i) {
+        auto block = GetBlocks(chunk) + i * chunk->block_size;
+        if (reinterpret_cast<FreeBlock*>(block)->tag == &kFreeTag) {
+            continue;
+        }
+        if (chunk->marked[i]) {
+            ++live;
+            continue;
+        }
+        reinterpret_cast<Object*>(block)->~Object();
+        new (block) FreeBlock{&kFreeTag, nullptr};
+    }
+    chunk->marked.reset();
+    return live;
+}
+
+void Heap::LinkFree(Chunk* chunk, SizeClass* size_class) {
+    for (size_t i = 0; i < chunk->used; ++i) {
+        auto block = reinterpret_cast<FreeBlock*>(GetBlocks(chunk) + i * chunk->block_size);
+        if (block->tag == &kFreeTag) {
+            block->next = std::exchange(size_class->free, block);
+        }
+    }
+}
+
+Heap::Stats Heap::GetStats() const {
+    return {.used_bytes = live_bytes_ + allocated_bytes_,
+            .chunk_bytes = chunks_ * kChunkSize,
+            .collections = collections_};
+}
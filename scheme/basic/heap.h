@@ -0,0 +1,225 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "profiler.h"
+
+class Object;
+
+// Reference to a Scheme object. Handles don't own anything: an object lives on
+// a Heap until a collection finds it unreachable, so copying a handle is as
+// cheap as copying a pointer.
+template <class T>
+class Handle {
+public:
+    Handle() = default;
+
+    Handle(std::nullptr_t) {
+    }
+
+    explicit Handle(T* ptr) : ptr_(ptr) {
+    }
+
+    template <class U>
+        requires std::is_convertible_v<U*, T*>
+    Handle(Handle<U> other) : ptr_(other.get()) {
+    }
+
+    T* get() const {
+        return ptr_;
+    }
+
+    T* operator->() const {
+        return ptr_;
+    }
+
+    T& operator*() const {
+        return *ptr_;
+    }
+
+    explicit operator bool() const {
+        return ptr_ != nullptr;
+    }
+
+    bool operator==(const Handle&) const = default;
+
+private:
+    T* ptr_ = nullptr;
+};
+
+// Scheme heap with a mark-sweep collector. Objects are carved out of 64 KiB
+// chunks, a list of them per size class, by a bump pointer, and blocks freed by
+// a collection are reused through free lists. Chunks left empty are kept for
+// other heaps if there are only a few idle ones, otherwise they go back to the
+// system.
+//
+// A heap is used by one thread at a time. Collect frees the objects that the
+// given roots don't reach; it doesn't look into other heaps, so objects of
+// another heap must never point into this one. Data that outlives evaluation
+// (hash-consed or cached programs) lives on heaps that are never collected and
+// is destroyed together with them.
+class Heap {
+public:
+    struct Stats {
+        size_t used_bytes = 0;   // in the blocks of objects not freed yet
+        size_t chunk_bytes = 0;  // taken from the system
+        size_t collections = 0;
+    };
+
+    Heap();
+    ~Heap();
+
+    Heap(const Heap&) = delete;
+    Heap& operator=(const Heap&) = delete;
+
+    // Heap of the innermost HeapScope of the calling thread. Without one it's a
+    // heap of the thread which is never collected and lives until it exits.
+    static Heap& Current();
+
+    template <class T, class... Args>
+    Handle<T> New(Args&&... args) {
+        static_assert(std::is_base_of_v<Object, T>);
+        static_assert(sizeof(T) <= kMaxObjectSize && alignof(T) <= kGranule);
+        SCHEME_PROFILE_ALLOCATION();
+        auto& size_class = classes_[(sizeof(T) + kGranule - 1) / kGranule];
+        void* memory;
+        if (size_class.free) {
+            memory = std::exchange(size_class.free, size_class.free->next);
+        } else if (size_class.cur != size_class.end) {
+            memory = std::exchange(size_class.cur, size_class.cur + size_class.block_size);
+        } else {
+            memory = Refill(&size_class);
+        }
+        allocated_bytes_ += size_class.block_size;
+        try {
+            return Handle<T>(new (memory) T(std::forward<Args>(args)...));
+        } catch (...) {
+            Free(&size_class, memory);
+            throw;
+        }
+    }
+
+    // Frees every object of the heap that isn't reachable from |roots|. Null
+    // roots and objects of other heaps are ignored.
+    void Collect(std::span<Object* const> roots);
+
+    // Whether enough has been allocated since the last collection to make
+    // another one worthwhile: at least as much as survived it, and 1 MiB.
+    bool ShouldCollect() const {
+        return allocated_bytes_ >= next_collection_;
+    }
+
+    Stats GetStats() const;
+
+private:
+    friend class HeapScope;
+
+    static constexpr size_t kChunkSize = 64 << 10;
+    static constexpr size_t kGranule = 16;
+    static constexpr size_t kMaxObjectSize = 256;
+    static constexpr size_t kMaxBlocks = kChunkSize / kGranule;
+    static constexpr size_t kMinCollection = 1 << 20;
+    static constexpr size_t kMaxIdleChunks = 16;
+
+    // Free blocks start with the address of kFreeTag where a live object has
+    // its vtable pointer, so sweeping can tell them apart.
+    struct FreeBlock {
+        const void* tag;
+        FreeBlock* next;
+    };
+
+    struct Chunk {
+        Heap* heap;
+        Chunk* next;
+        size_t block_size;
+        size_t used = 0;  // blocks handed out by the bump pointer
+        std::bitset<kMaxBlocks> marked;
+    };
+
+    struct SizeClass {
+        size_t block_size = 0;
+        Chunk* chunks = nullptr;
+        FreeBlock* free = nullptr;
+        std::byte* cur = nullptr;  // bump pointer in the newest chunk
+        std::byte* end = nullptr;
+    };
+
+    static constexpr size_t kHeaderSize = (sizeof(Chunk) + kGranule - 1) / kGranule * kGranule;
+    static constexpr char kFreeTag = 0;
+
+    static Chunk* GetChunk(const void* ptr) {
+        return reinterpret_cast<Chunk*>(reinterpret_cast<uintptr_t>(ptr) & ~(kChunkSize - 1));
+    }
+
+    static std::byte* GetBlocks(Chunk* chunk) {
+        return reinterpret_cast<std::byte*>(chunk) + kHeaderSize;
+    }
+
+    static void* NewChunk();
+    static void ReleaseChunk(Chunk* chunk);
+
+    void* Refill(SizeClass* size_class);
+    void Free(SizeClass* size_class, void* memory);
+
+    // Settles the bump pointer of |size_class| into the used count of its chunk.
+    static void Retire(SizeClass* size_class);
+
+    // Sets the mark of |object| if it is on this heap, returns whether it was
+    // newly marked.
+    bool Mark(Object* object);
+
+    // Destroys the unmarked objects of |chunk| and clears the marks. Returns the
+    // amount of live blocks left.
+    static size_t Sweep(Chunk* chunk);
+
+    // Puts the free blocks of |chunk| on the free list of |size_class|.
+    static void LinkFree(Chunk* chunk, SizeClass* size_class);
+
+    std::array<SizeClass, kMaxObjectSize / kGranule + 1> classes_;
+    size_t allocated_bytes_ = 0;  // since the last collection
+    size_t live_bytes_ = 0;       // as of the last collection
+    size_t next_collection_ = kMinCollection;
+    size_t chunks_ = 0;
+    size_t collections_ = 0;
+    std::vector<Object*> mark_stack_;
+
+    static inline thread_local Heap* current_ = nullptr;
+
+    // Trivially destructible as well, heaps may be destroyed during static
+    // destruction.
+    static inline std::mutex idle_mutex_;
+    static inline std::array<void*, kMaxIdleChunks> idle_;
+    static inline size_t idle_count_ = 0;
+};
+
+// Makes |heap| the current heap of the thread while it exists.
+class HeapScope {
+public:
+    explicit HeapScope(Heap* heap) : previous_(std::exchange(Heap::current_, heap)) {
+    }
+
+    ~HeapScope() {
+        Heap::current_ = previous_;
+    }
+
+    HeapScope(const HeapScope&) = delete;
+    HeapScope& operator=(const HeapScope&) = delete;
+
+private:
+    Heap* previous_;
+};
+
+// Creates a Scheme object on the current heap.
+template <class T, class... Args>
+Handle<T> New(Args&&... args) {
+    return Heap::Current().New<T>(std::forward<Args>(args)...);
+}
@@ -0,0 +1,110 @@
+// List churn benchmark of the Scheme heap: programs that build large lists and
+// drop them right away. Not part of a build target, from this directory:
+//   g++ -std=c++20 -O2 -pthread -I. heap_benchmark.cpp $(ls *.cpp | grep -v '_benchmark\|_test')
+//   ./heap_benchmark [lists] [length]
+//
+// read:  RunForms over |lists| forms, each taking the car of a quoted list of
+//        |length| numbers, so every form leaves a whole list behind.
+// cons:  a single Run summing lists * length / 8 (car (cons i (1 2 3))) terms,
+//        every one of which allocates a cell that is garbage right after.
+// batch: RunBatch of the forms of read as separate programs.
+//
+// Every row runs in a child process, so its peak RSS is that of the workload
+// alone.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "scheme.h"
+
+namespace {
+
+std::string MakeList(int length, int start) {
+    std::string list = "(car (quote (";
+    for (int i = 0; i < length; ++i) {
+        list += std::to_string(start + i);
+        list += ' ';
+    }
+    list += ")))";
+    return list;
+}
+
+std::string MakeConsSum(int terms) {
+    std::string sum = "(+";
+    for (int i = 0; i < terms; ++i) {
+        sum += " (car (cons " + std::to_string(i) + " (1 2 3)))";
+    }
+    sum += ')';
+    return sum;
+}
+
+// Returns a checksum of the results, so nothing is optimized away.
+size_t RunWorkload(const std::string& workload, EvaluationMode mode, int lists, int length) {
+    Interpreter interpreter(mode);
+    size_t checksum = 0;
+    if (workload == "read") {
+        std::string input;
+        for (int i = 0; i < lists; ++i) {
+            input += MakeList(length, i);
+            input += '\n';
+        }
+        interpreter.RunForms(input, [&checksum](const std::string& result) {
+            checksum += result.size();
+        });
+    } else if (workload == "cons") {
+        checksum = interpreter.Run(MakeConsSum(lists * length / 8)).size();
+    } else {
+        std::vector<std::string> programs;
+        for (int i = 0; i < lists; ++i) {
+            programs.push_back(MakeList(length, i));
+        }
+        for (const auto& result : interpreter.RunBatch(programs)) {
+            checksum += result.size();
+        }
+    }
+    return checksum;
+}
+
+void PrintRow(const std::string& workload, EvaluationMode mode, int lists, int length) {
+    std::fflush(stdout);
+    if (fork() != 0) {
+        wait(nullptr);
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto checksum = RunWorkload(workload, mode, lists, length);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    std::printf("%8s %10s %10.1f %12.1f %10zu\n", workload.c_str(),
+                mode == EvaluationMode::TREE_WALK ? "tree-walk" : "bytecode", elapsed.count(),
+                usage.ru_maxrss / 1024.0, checksum);
+    std::fflush(stdout);
+    _exit(0);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    auto lists = argc > 1 ? std::atoi(argv[1]) : 2000;
+    auto length = argc > 2 ? std::atoi(argv[2]) : 1000;
+    if (lists < 1 || length < 1) {
+        std::fprintf(stderr, "usage: %s [lists] [length]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("%d lists of %d numbers\n", lists, length);
+    std::printf("%8s %10s %10s %12s %10s\n", "workload", "mode", "ms", "peak RSS MB", "checksum");
+    for (const char* workload : {"read", "cons", "batch"}) {
+        for (auto mode : {EvaluationMode::TREE_WALK, EvaluationMode::BYTECODE}) {
+            PrintRow(workload, mode, lists, length);
+        }
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only memory mapping of a whole file. MappedInput of the JPEG decoder
+// repeats this code, keep the two in sync.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view GetData() const {
+        return {data_, size_};
+    }
+
+    ~MappedFile();
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
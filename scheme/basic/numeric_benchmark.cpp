@@ -0,0 +1,78 @@
+// Fixnum and bignum arithmetic. Not part of a build target, from this directory:
+//   g++ -std=c++20 -O2 -pthread -I. numeric_benchmark.cpp $(ls *.cpp | grep -v '_benchmark\|_test')
+//   ./numeric_benchmark [fib n]
+//
+// Without procedures, factorial and fibonacci are written out: fact 20 is
+// (* 1 2 ... 20), the largest factorial that fits a fixnum, and fib n expands
+// (+ fib(n - 1) fib(n - 2)) down to the literals 0 and 1, so every one of its
+// additions stays a fixnum. fact 100 overflows after 20 factors and has to go
+// through BigInteger. Programs are read from a ProgramCache, so only evaluation
+// is timed.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <utility>
+
+#include "program_cache.h"
+#include "scheme.h"
+
+namespace {
+
+constexpr std::chrono::milliseconds kDuration{500};
+
+std::string Factorial(int n) {
+    std::string product = "(*";
+    for (int i = 1; i <= n; ++i) {
+        product += ' ' + std::to_string(i);
+    }
+    product += ')';
+    return product;
+}
+
+std::string Fibonacci(int n) {
+    if (n < 2) {
+        return std::to_string(n);
+    }
+    return "(+ " + Fibonacci(n - 1) + ' ' + Fibonacci(n - 2) + ')';
+}
+
+// Runs per second of |run|.
+double Measure(const std::function<void()>& run) {
+    size_t runs = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed{};
+    while (elapsed < kDuration) {
+        run();
+        ++runs;
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    return runs / elapsed.count();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    auto fib = argc > 1 ? std::atoi(argv[1]) : 20;
+    if (fib < 0 || fib > 30) {
+        std::fprintf(stderr, "usage: %s [fib n <= 30]\n", argv[0]);
+        return 1;
+    }
+
+    auto fib_name = "fib " + std::to_string(fib);
+    std::printf("runs/s\n");
+    std::printf("%10s %14s %14s\n", "program", "tree-walk", "bytecode");
+    for (auto [name, program] : {std::pair{std::string("fact 20"), Factorial(20)},
+                                 std::pair{fib_name, Fibonacci(fib)},
+                                 std::pair{std::string("fact 100"), Factorial(100)}}) {
+        std::printf("%10s", name.c_str());
+        for (auto mode : {EvaluationMode::TREE_WALK, EvaluationMode::BYTECODE}) {
+            ProgramCache cache(1);
+            Interpreter interpreter(mode, &cache);
+            std::printf(" %14.1f", Measure([&] { interpreter.Run(program); }));
+        }
+        std::printf("\n");
+    }
+}
@@ -4,34 +4,179 @@
 #include <cstddef>
 #include <cstdint>
 #include <iterator>
+#include <limits>
 #include <memory>
 #include <numeric>
 #include <vector>
-#include <list>
+#include "compiler.h"
 #include "error.h"
+#include "profiler.h"
+#include "value.h"
+
+// Collects the elements of |list| and stores its final cdr (nullptr for a proper list) in |tail|.
+static ArgList Collect(const Handle<Object>& list, Handle<Object>* tail) {
+    ArgList elements;
+    auto cur = list;
+    while (auto cell = As<Cell>(cur)) {
+        elements.push_back(cell->GetFirst());
+        cur = cell->GetSecond();
+    }
+    *tail = std::move(cur);
+    return elements;
+}
 
-using FlattenedCell = std::list<std::shared_ptr<Object>>;
+// Final cdr of |list| and the amount of cells before it.
+static std::pair<Handle<Object>, size_t> GetTail(Handle<Object> list) {
+    size_t size = 0;
+    while (auto cell = As<Cell>(list)) {
+        list = cell->GetSecond();
+        ++size;
+    }
+    return {list, size};
+}
 
-static FlattenedCell Flatten(const Cell& cell) {
-    FlattenedCell ans = {cell.GetFirst()};
-    if (auto next_cell = As<Cell>(cell.GetSecond())) {
-        ans.splice(ans.end(), Flatten(*next_cell));
-    } else {
-        ans.emplace_back(cell.GetSecond());
+static Handle<Object> EvaluateArg(const Handle<Object>& arg) {
+    if (!arg) {
+        throw RuntimeError("Empty list is not evaluatable!");
     }
-    return ans;
+    return arg->Evaluate();
 }
 
-bool Symbol::IsFunction() const {
-    for (const auto& func : Function::kFunctions) {
-        if (func->Check(*this)) {
-            return true;
+// Numeric tower: numbers are int64_t fixnums, results that don't fit are
+// promoted to BigNumber. Every operation below has a fixnum fast path, which
+// reports overflow instead of wrapping, and a BigInteger fallback.
+
+static bool IsNumber(const Value& value) {
+    return value.IsFixnum() || Is<BigNumber>(value.GetObject());
+}
+
+static BigInteger GetBigInteger(const Value& value) {
+    if (value.IsFixnum()) {
+        return value.GetFixnum();
+    }
+    if (auto number = As<BigNumber>(value.GetObject())) {
+        return number->GetValue();
+    }
+    throw RuntimeError("Args are not numbers!");
+}
+
+// Demotes results that fit into a fixnum, so BigNumber only holds large values.
+static Value MakeNumber(BigInteger value) {
+    if (value.FitsInt64()) {
+        return Value::Fixnum(value.ToInt64());
+    }
+    return Value(New<BigNumber>(std::move(value)));
+}
+
+struct Plus {
+    static bool Fixnum(int64_t lhs, int64_t rhs, int64_t* result) {
+        return !__builtin_add_overflow(lhs, rhs, result);
+    }
+    static BigInteger Big(const BigInteger& lhs, const BigInteger& rhs) {
+        return lhs + rhs;
+    }
+};
+
+struct Minus {
+    static bool Fixnum(int64_t lhs, int64_t rhs, int64_t* result) {
+        return !__builtin_sub_overflow(lhs, rhs, result);
+    }
+    static BigInteger Big(const BigInteger& lhs, const BigInteger& rhs) {
+        return lhs - rhs;
+    }
+};
+
+struct Multiplies {
+    static bool Fixnum(int64_t lhs, int64_t rhs, int64_t* result) {
+        return !__builtin_mul_overflow(lhs, rhs, result);
+    }
+    static BigInteger Big(const BigInteger& lhs, const BigInteger& rhs) {
+        return lhs * rhs;
+    }
+};
+
+struct Divides {
+    static bool Fixnum(int64_t lhs, int64_t rhs, int64_t* result) {
+        if (rhs == 0 || (lhs == std::numeric_limits<int64_t>::min() && rhs == -1)) {
+            return false;
+        }
+        *result = lhs / rhs;
+        return true;
+    }
+    static BigInteger Big(const BigInteger& lhs, const BigInteger& rhs) {
+        if (rhs.IsZero()) {
+            throw RuntimeError("Division by zero!");
+        }
+        return lhs / rhs;
+    }
+};
+
+struct Min {
+    static bool Fixnum(int64_t lhs, int64_t rhs, int64_t* result) {
+        *result = std::min(lhs, rhs);
+        return true;
+    }
+    static BigInteger Big(const BigInteger& lhs, const BigInteger& rhs) {
+        return std::min(lhs, rhs);
+    }
+};
+
+struct Max {
+    static bool Fixnum(int64_t lhs, int64_t rhs, int64_t* result) {
+        *result = std::max(lhs, rhs);
+        return true;
+    }
+    static BigInteger Big(const BigInteger& lhs, const BigInteger& rhs) {
+        return std::max(lhs, rhs);
+    }
+};
+
+struct Abs {
+    static bool Fixnum(int64_t value, int64_t* result) {
+        if (value == std::numeric_limits<int64_t>::min()) {
+            return false;
         }
+        *result = std::abs(value);
+        return true;
+    }
+    static BigInteger Big(const BigInteger& value) {
+        return value.Abs();
+    }
+};
+
+template <class Op>
+static Value Compute(const Value& lhs, const Value& rhs) {
+    int64_t result;
+    if (lhs.IsFixnum() && rhs.IsFixnum() && Op::Fixnum(lhs.GetFixnum(), rhs.GetFixnum(), &result))
+        [[likely]] {
+        return Value::Fixnum(result);
+    }
+    return MakeNumber(Op::Big(GetBigInteger(lhs), GetBigInteger(rhs)));
+}
+
+template <class Op>
+static Value Compute(const Value& value) {
+    int64_t result;
+    if (value.IsFixnum() && Op::Fixnum(value.GetFixnum(), &result)) [[likely]] {
+        return Value::Fixnum(result);
+    }
+    return MakeNumber(Op::Big(GetBigInteger(value)));
+}
+
+// Sign of lhs - rhs.
+static int Compare(const Value& lhs, const Value& rhs) {
+    if (lhs.IsFixnum() && rhs.IsFixnum()) [[likely]] {
+        return (lhs.GetFixnum() > rhs.GetFixnum()) - (lhs.GetFixnum() < rhs.GetFixnum());
     }
-    return false;
+    auto order = GetBigInteger(lhs) <=> GetBigInteger(rhs);
+    return (order > 0) - (order < 0);
+}
+
+bool Symbol::IsFunction() const {
+    return GetFunction() != nullptr;
 }
 
-const std::array<std::unique_ptr<Function>, 27> Function::kFunctions = {
+const std::array<std::unique_ptr<Function>, 28> Function::kFunctions = {
     {std::make_unique<QuoteFunction>("quote"),
      std::make_unique<IsBooleanFunction>("boolean?"),
      std::make_unique<IsNumberFunction>("number?"),
@@ -45,7 +190,8 @@ const std::array<std::unique_ptr<Function>, 27> Function::kFunctions = {
      std::make_unique<ListFunction>("list"),
      std::make_unique<ListRefFunction>("list-ref"),
      std::make_unique<ListTailFunction>("list-tail"),
-     std::make_unique<UnaryFunction<decltype([](int64_t x) { return std::abs(x); })>>("abs"),
+     std::make_unique<EqualFunction>("equal?"),
+     std::make_unique<UnaryFunction<Abs>>("abs"),
      std::make_unique<CmpFunction<std::equal_to<>>>("="),
      std::make_unique<CmpFunction<std::less<>>>("<"),
      std::make_unique<CmpFunction<std::greater<>>>(">"),
@@ -53,202 +199,333 @@ const std::array<std::unique_ptr<Function>, 27> Function::kFunctions = {
      std::make_unique<CmpFunction<std::greater_equal<>>>(">="),
      std::make_unique<LogicFunction<false, std::logical_or<>>>("or"),
      std::make_unique<LogicFunction<true, std::logical_and<>>>("and"),
-     std::make_unique<FoldFunction<0, std::plus<>>>("+"),
-     std::make_unique<FoldFunction<1, std::multiplies<>>>("*"),
-     std::make_unique<
-         BinaryFunction<decltype([](int64_t l, int64_t r) { return std::min(l, r); })>>("min"),
-     std::make_unique<
-         BinaryFunction<decltype([](int64_t l, int64_t r) { return std::max(l, r); })>>("max"),
-     std::make_unique<BinaryFunction<std::minus<>>>("-"),
-     std::make_unique<BinaryFunction<std::divides<>>>("/")}};
-
-void Function::CheckCtx(std::shared_ptr<Object> ctx) {
+     std::make_unique<FoldFunction<0, Plus>>("+"),
+     std::make_unique<FoldFunction<1, Multiplies>>("*"),
+     std::make_unique<BinaryFunction<Min>>("min"),
+     std::make_unique<BinaryFunction<Max>>("max"),
+     std::make_unique<BinaryFunction<Minus>>("-"),
+     std::make_unique<BinaryFunction<Divides>>("/")}};
+
+static const SymbolId kTrueId = Intern("#t");
+static const SymbolId kFalseId = Intern("#f");
+
+Handle<Symbol> Symbol::GetBoolean(bool value) {
+    static auto heap = new Heap;
+    static const auto kTrue = heap->New<Symbol>(kTrueId);
+    static const auto kFalse = heap->New<Symbol>(kFalseId);
+    return value ? kTrue : kFalse;
+}
+
+bool Symbol::IsBoolean() const {
+    return id_ == kTrueId || id_ == kFalseId;
+}
+
+Symbol::operator bool() {
+    return id_ != kFalseId;
+}
+
+Function* Symbol::GetFunction() const {
+    // Builtins are indexed by the ids of their names.
+    static const auto kTable = [] {
+        std::vector<Function*> table;
+        for (const auto& func : Function::kFunctions) {
+            if (table.size() <= func->GetId()) {
+                table.resize(func->GetId() + 1);
+            }
+            table[func->GetId()] = func.get();
+        }
+        return table;
+    }();
+    return id_ < kTable.size() ? kTable[id_] : nullptr;
+}
+
+void Function::CheckCtx(Handle<Object> ctx) {
     if (!ctx || !Is<Cell>(ctx)) {
         throw RuntimeError("Expected argument for " + name_ + "!");
     }
 }
-void Function::CheckAmountOfArgs(std::shared_ptr<Object> ctx, size_t amount) {
+
+ArgList Function::GetArgs(Handle<Object> ctx, size_t amount) {
     CheckCtx(ctx);
-    auto args = Flatten(*As<Cell>(ctx));
-    if (args.back() != nullptr) {
+    Handle<Object> tail;
+    auto args = Collect(ctx, &tail);
+    if (tail != nullptr) {
         throw RuntimeError("Args are not a proper list!");
     }
-    args.pop_back();  // remove nullptr
     if (args.size() != amount) {
         throw RuntimeError("Incorrect amount of args!");
     }
+    return args;
 }
 
-std::string Cell::Serialize() {
-    auto elements = Flatten(*this);
-    auto add_point = elements.back() != nullptr;
-    if (!add_point) {
-        elements.pop_back();  // remove nullptr
+Handle<Object> Function::EvaluateApply(Handle<Object> ctx, size_t amount) {
+    SmallVector<Value, 8> values;
+    for (const auto& arg : GetArgs(ctx, amount)) {
+        values.emplace_back(EvaluateArg(arg));
     }
+    return Apply(values).ToObject();
+}
 
-    std::vector<std::string> names;
-    std::ranges::transform(elements, std::back_insert_iterator(names),
-                           [](const std::shared_ptr<Object>& object) -> std::string {
-                               if (!object) {
-                                   return "()";
-                               }
-                               return object->Serialize();
-                           });
-    if (add_point) {
-        names.emplace(std::prev(names.end()), ".");
+void Function::Compile(Handle<Object> ctx, Compiler* compiler) {
+    compiler->EmitCall(this, std::move(ctx));
+}
+
+Value Function::Apply(std::span<Value>) {
+    throw RuntimeError("Can't apply " + name_ + " to evaluated args!");
+}
+
+void Function::CompileApply(Handle<Object> ctx, size_t amount, Compiler* compiler) {
+    for (const auto& arg : GetArgs(ctx, amount)) {
+        compiler->EmitEvaluate(arg);
     }
-    return "(" +
-           std::accumulate(std::next(names.begin()), names.end(), names[0],
-                           [](const std::string& a, const std::string& b) { return a + " " + b; }) +
-           ")";
+    compiler->EmitApply(this, amount);
 }
 
-std::shared_ptr<Object> Symbol::Evaluate(std::shared_ptr<Object> ctx) {
-    for (const auto& func : Function::kFunctions) {
-        if (!func->Check(*this)) {
+void Cell::SerializeTo(std::string* out) {
+    // Work items: either an element to write or a cell whose car is written
+    // already and whose cdr comes next. Only nesting grows the stack.
+    struct Item {
+        Object* object;
+        bool is_rest;
+    };
+    std::vector<Item> items = {{this, false}};
+    while (!items.empty()) {
+        auto [object, is_rest] = items.back();
+        items.pop_back();
+
+        if (!is_rest) {
+            if (!object) {
+                out->append("()");
+            } else if (auto cell = dynamic_cast<Cell*>(object)) {
+                out->push_back('(');
+                items.push_back({cell, true});
+                items.push_back({cell->first_.get(), false});
+            } else {
+                object->SerializeTo(out);
+            }
             continue;
         }
 
+        auto rest = static_cast<Cell*>(object)->second_.get();
+        if (!rest) {
+            out->push_back(')');
+        } else if (auto cell = dynamic_cast<Cell*>(rest)) {
+            out->push_back(' ');
+            items.push_back({cell, true});
+            items.push_back({cell->first_.get(), false});
+        } else {
+            out->append(" . ");
+            rest->SerializeTo(out);
+            out->push_back(')');
+        }
+    }
+}
+
+Handle<Object> Symbol::Evaluate(Handle<Object> ctx) {
+    if (auto func = GetFunction()) {
         return func->Evaluate(ctx);
     }
 
-    return std::make_shared<Symbol>(name_);
+    return Handle<Object>(this);
 };
 
-std::shared_ptr<Object> QuoteFunction::Evaluate(std::shared_ptr<Object> ctx) {
-    CheckAmountOfArgs(ctx, 1);
+Handle<Object> QuoteFunction::Evaluate(Handle<Object> ctx) {
+    return GetArgs(ctx, 1)[0];
+}
 
-    return As<Cell>(ctx)->GetFirst();
+void QuoteFunction::Compile(Handle<Object> ctx, Compiler* compiler) {
+    compiler->EmitConstant(GetArgs(ctx, 1)[0]);
 }
 
-std::shared_ptr<Object> IsBooleanFunction::Evaluate(std::shared_ptr<Object> ctx) {
-    CheckAmountOfArgs(ctx, 1);
+Handle<Object> IsBooleanFunction::Evaluate(Handle<Object> ctx) {
+    return EvaluateApply(ctx, 1);
+}
 
-    if (auto symbol = As<Symbol>(As<Cell>(ctx)->GetFirst()->Evaluate())) {
-        return std::make_shared<Symbol>(symbol->GetName() == "#f" || symbol->GetName() == "#t");
-    } else {
-        return std::make_shared<Symbol>(false);
-    }
+void IsBooleanFunction::Compile(Handle<Object> ctx, Compiler* compiler) {
+    CompileApply(ctx, 1, compiler);
 }
 
-std::shared_ptr<Object> IsNumberFunction::Evaluate(std::shared_ptr<Object> ctx) {
-    CheckAmountOfArgs(ctx, 1);
+Value IsBooleanFunction::Apply(std::span<Value> args) {
+    return Value::Boolean(args[0].IsBoolean());
+}
 
-    return std::make_shared<Symbol>(Is<Number>(As<Cell>(ctx)->GetFirst()));
+Handle<Object> IsNumberFunction::Evaluate(Handle<Object> ctx) {
+    return Symbol::GetBoolean(IsNumber(Value(GetArgs(ctx, 1)[0])));
 }
 
-std::shared_ptr<Object> IsPairFunction::Evaluate(std::shared_ptr<Object> ctx) {
-    CheckAmountOfArgs(ctx, 1);
+void IsNumberFunction::Compile(Handle<Object> ctx, Compiler* compiler) {
+    compiler->EmitConstant(Symbol::GetBoolean(IsNumber(Value(GetArgs(ctx, 1)[0]))));
+}
 
-    return std::make_shared<Symbol>(Is<Cell>(As<Cell>(ctx)->GetFirst()->Evaluate()));
+Handle<Object> IsPairFunction::Evaluate(Handle<Object> ctx) {
+    return EvaluateApply(ctx, 1);
 }
 
-std::shared_ptr<Object> IsNullFunction::Evaluate(std::shared_ptr<Object> ctx) {
-    CheckAmountOfArgs(ctx, 1);
+void IsPairFunction::Compile(Handle<Object> ctx, Compiler* compiler) {
+    CompileApply(ctx, 1, compiler);
+}
 
-    return std::make_shared<Symbol>(!As<Cell>(ctx)->GetFirst()->Evaluate());
+Value IsPairFunction::Apply(std::span<Value> args) {
+    return Value::Boolean(Is<Cell>(args[0].GetObject()));
 }
 
-std::shared_ptr<Object> IsListFunction::Evaluate(std::shared_ptr<Object> ctx) {
-    CheckAmountOfArgs(ctx, 1);
+Handle<Object> IsNullFunction::Evaluate(Handle<Object> ctx) {
+    return EvaluateApply(ctx, 1);
+}
 
-    if (auto list = As<Cell>(As<Cell>(ctx)->GetFirst()->Evaluate())) {
-        auto flattened = Flatten(*list);
-        return std::make_shared<Symbol>(!flattened.empty() && flattened.back() == nullptr);
-    }
+void IsNullFunction::Compile(Handle<Object> ctx, Compiler* compiler) {
+    CompileApply(ctx, 1, compiler);
+}
 
-    if (As<Cell>(ctx)->GetFirst()->Evaluate() == nullptr) {
-        return std::make_shared<Symbol>(true);
-    }
+Value IsNullFunction::Apply(std::span<Value> args) {
+    return Value::Boolean(args[0].IsEmpty());
+}
 
-    return std::make_shared<Symbol>(false);
+Handle<Object> IsListFunction::Evaluate(Handle<Object> ctx) {
+    return EvaluateApply(ctx, 1);
 }
 
-std::shared_ptr<Object> NotFunction::Evaluate(std::shared_ptr<Object> ctx) {
-    CheckAmountOfArgs(ctx, 1);
+void IsListFunction::Compile(Handle<Object> ctx, Compiler* compiler) {
+    CompileApply(ctx, 1, compiler);
+}
 
-    if (auto symbol = As<Symbol>(As<Cell>(ctx)->GetFirst()->Evaluate())) {
-        return std::make_shared<Symbol>(symbol->GetName() == "#f");
-    } else {
-        return std::make_shared<Symbol>(false);
+Value IsListFunction::Apply(std::span<Value> args) {
+    if (Is<Cell>(args[0].GetObject())) {
+        return Value::Boolean(GetTail(args[0].GetObject()).first == nullptr);
     }
+    return Value::Boolean(args[0].IsEmpty());
+}
+
+Handle<Object> NotFunction::Evaluate(Handle<Object> ctx) {
+    return EvaluateApply(ctx, 1);
+}
+
+void NotFunction::Compile(Handle<Object> ctx, Compiler* compiler) {
+    CompileApply(ctx, 1, compiler);
 }
 
-std::shared_ptr<Object> ConsFunction::Evaluate(std::shared_ptr<Object> ctx) {
-    CheckAmountOfArgs(ctx, 2);
+Value NotFunction::Apply(std::span<Value> args) {
+    return Value::Boolean(args[0].IsBoolean() && !args[0]);
+}
 
-    auto args = Flatten(*As<Cell>(ctx));
-    args.pop_back();
+Handle<Object> ConsFunction::Evaluate(Handle<Object> ctx) {
+    auto args = GetArgs(ctx, 2);
 
-    return std::make_shared<Cell>(args.front(), args.back());
+    return New<Cell>(args[0], args[1]);
 }
 
-std::shared_ptr<Object> CarFunction::Evaluate(std::shared_ptr<Object> ctx) {
-    CheckAmountOfArgs(ctx, 1);
+void ConsFunction::Compile(Handle<Object> ctx, Compiler* compiler) {
+    auto args = GetArgs(ctx, 2);
+
+    compiler->EmitConstant(args[0]);
+    compiler->EmitConstant(args[1]);
+    compiler->EmitApply(this, 2);
+}
 
-    if (auto cell = As<Cell>(As<Cell>(ctx)->GetFirst()->Evaluate())) {
-        return cell->GetFirst();
+Value ConsFunction::Apply(std::span<Value> args) {
+    return Value(New<Cell>(args[0].ToObject(), args[1].ToObject()));
+}
+
+Handle<Object> CarFunction::Evaluate(Handle<Object> ctx) {
+    return EvaluateApply(ctx, 1);
+}
+
+void CarFunction::Compile(Handle<Object> ctx, Compiler* compiler) {
+    CompileApply(ctx, 1, compiler);
+}
+
+Value CarFunction::Apply(std::span<Value> args) {
+    if (auto cell = As<Cell>(args[0].GetObject())) {
+        return Value(cell->GetFirst());
     } else {
         throw RuntimeError("Expected list for 'car'!");
     }
 }
 
-std::shared_ptr<Object> CdrFunction::Evaluate(std::shared_ptr<Object> ctx) {
-    CheckAmountOfArgs(ctx, 1);
+Handle<Object> CdrFunction::Evaluate(Handle<Object> ctx) {
+    return EvaluateApply(ctx, 1);
+}
 
-    if (auto cell = As<Cell>(As<Cell>(ctx)->GetFirst()->Evaluate())) {
-        return cell->GetSecond();
+void CdrFunction::Compile(Handle<Object> ctx, Compiler* compiler) {
+    CompileApply(ctx, 1, compiler);
+}
+
+Value CdrFunction::Apply(std::span<Value> args) {
+    if (auto cell = As<Cell>(args[0].GetObject())) {
+        return Value(cell->GetSecond());
     } else {
         throw RuntimeError("Expected list for 'cdr'!");
     }
 }
 
-std::shared_ptr<Object> ListFunction::Evaluate(std::shared_ptr<Object> ctx) {
+Handle<Object> ListFunction::Evaluate(Handle<Object> ctx) {
     return ctx;
 }
 
-std::shared_ptr<Object> ListRefFunction::Evaluate(std::shared_ptr<Object> ctx) {
-    CheckAmountOfArgs(ctx, 2);
+void ListFunction::Compile(Handle<Object> ctx, Compiler* compiler) {
+    compiler->EmitConstant(std::move(ctx));
+}
+
+// list-ref and list-tail take an evaluated list and a literal index.
+static Handle<Object> EvaluateListIndex(Function* function, const ArgList& args) {
+    Value values[] = {Value(EvaluateArg(args[0])), Value(args[1])};
+    return function->Apply(values).ToObject();
+}
 
-    auto args = Flatten(*As<Cell>(ctx));
-    args.pop_back();  // remove nullptr
+static void CompileListIndex(Function* function, const ArgList& args, Compiler* compiler) {
+    compiler->EmitEvaluate(args[0]);
+    compiler->EmitConstant(args[1]);
+    compiler->EmitApply(function, 2);
+}
 
-    auto list = As<Cell>(args.front()->Evaluate());
+Handle<Object> ListRefFunction::Evaluate(Handle<Object> ctx) {
+    return EvaluateListIndex(this, GetArgs(ctx, 2));
+}
+
+void ListRefFunction::Compile(Handle<Object> ctx, Compiler* compiler) {
+    CompileListIndex(this, GetArgs(ctx, 2), compiler);
+}
+
+Value ListRefFunction::Apply(std::span<Value> args) {
+    auto list = As<Cell>(args[0].GetObject());
     if (!list) {
         throw RuntimeError("First arg should be list for 'list-ref'");
     }
-    if (!Is<Number>(args.back())) {
+    if (!args[1].IsFixnum()) {
         throw RuntimeError("Second arg should be number for 'list-ref'");
     }
 
-    auto idx = static_cast<size_t>(As<Number>(args.back())->GetValue());
-    auto flattened = Flatten(*list);
-    if (flattened.back()) {
+    auto idx = static_cast<size_t>(args[1].GetFixnum());
+    auto [tail, size] = GetTail(list);
+    if (tail) {
         throw RuntimeError("Not a proper list!");
     }
-    flattened.pop_back();
-    if (idx >= flattened.size()) {
+    if (idx >= size) {
         throw RuntimeError("Out of bounds!");
     }
-    auto ans = flattened.begin();
-    std::advance(ans, idx);
-    return *ans;
+    while (idx--) {
+        list = As<Cell>(list->GetSecond());
+    }
+    return Value(list->GetFirst());
 }
 
-std::shared_ptr<Object> ListTailFunction::Evaluate(std::shared_ptr<Object> ctx) {
-    CheckAmountOfArgs(ctx, 2);
+Handle<Object> ListTailFunction::Evaluate(Handle<Object> ctx) {
+    return EvaluateListIndex(this, GetArgs(ctx, 2));
+}
 
-    auto args = Flatten(*As<Cell>(ctx));
-    args.pop_back();  // remove nullptr
+void ListTailFunction::Compile(Handle<Object> ctx, Compiler* compiler) {
+    CompileListIndex(this, GetArgs(ctx, 2), compiler);
+}
 
-    auto list = As<Cell>(args.front()->Evaluate());
+Value ListTailFunction::Apply(std::span<Value> args) {
+    auto list = As<Cell>(args[0].GetObject());
     if (!list) {
         throw RuntimeError("First arg should be list for 'list-tail'");
     }
-    if (!Is<Number>(args.back())) {
+    if (!args[1].IsFixnum()) {
         throw RuntimeError("Second arg should be number for 'list-tail'");
     }
-    auto idx = static_cast<size_t>(As<Number>(args.back())->GetValue());
+    auto idx = static_cast<size_t>(args[1].GetFixnum());
 
     auto ans = list;
     while (idx--) {
@@ -257,100 +534,251 @@ std::shared_ptr<Object> ListTailFunction::Evaluate(std::shared_ptr<Object> ctx)
         }
         ans = As<Cell>(ans->GetSecond());
     }
-    return ans;
+    return Value(ans);
+}
+
+// Compares two structures without recursion. Shared subterms are skipped by a
+// pointer check, which makes hash-consed data compare in O(1).
+static bool Equal(const Handle<Object>& lhs, const Handle<Object>& rhs) {
+    std::vector<std::pair<Object*, Object*>> pending = {{lhs.get(), rhs.get()}};
+    while (!pending.empty()) {
+        auto [left, right] = pending.back();
+        pending.pop_back();
+        if (left == right) {
+            continue;
+        }
+        if (!left || !right) {
+            return false;
+        }
+        if (auto left_cell = dynamic_cast<Cell*>(left)) {
+            auto right_cell = dynamic_cast<Cell*>(right);
+            if (!right_cell) {
+                return false;
+            }
+            pending.emplace_back(left_cell->GetSecond().get(), right_cell->GetSecond().get());
+            pending.emplace_back(left_cell->GetFirst().get(), right_cell->GetFirst().get());
+        } else if (auto left_number = dynamic_cast<Number*>(left)) {
+            auto right_number = dynamic_cast<Number*>(right);
+            if (!right_number || left_number->GetValue() != right_number->GetValue()) {
+                return false;
+            }
+        } else if (auto left_number = dynamic_cast<BigNumber*>(left)) {
+            auto right_number = dynamic_cast<BigNumber*>(right);
+            if (!right_number || left_number->GetValue() != right_number->GetValue()) {
+                return false;
+            }
+        } else if (auto left_symbol = dynamic_cast<Symbol*>(left)) {
+            auto right_symbol = dynamic_cast<Symbol*>(right);
+            if (!right_symbol || left_symbol->GetId() != right_symbol->GetId()) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+Handle<Object> EqualFunction::Evaluate(Handle<Object> ctx) {
+    return EvaluateApply(ctx, 2);
+}
+
+void EqualFunction::Compile(Handle<Object> ctx, Compiler* compiler) {
+    CompileApply(ctx, 2, compiler);
+}
+
+Value EqualFunction::Apply(std::span<Value> args) {
+    if (args[0].GetTag() != args[1].GetTag()) {
+        return Value::Boolean(false);
+    }
+    if (args[0].IsFixnum() || args[0].IsBoolean()) {
+        return Value::Boolean(args[0].GetFixnum() == args[1].GetFixnum());
+    }
+    return Value::Boolean(Equal(args[0].GetObject(), args[1].GetObject()));
+}
+
+template <class Functor>
+Handle<Object> UnaryFunction<Functor>::Evaluate(Handle<Object> ctx) {
+    Value values[] = {Value(GetArgs(ctx, 1)[0])};
+    return Apply(values).ToObject();
 }
 
 template <class Functor>
-std::shared_ptr<Object> UnaryFunction<Functor>::Evaluate(std::shared_ptr<Object> ctx) {
-    CheckAmountOfArgs(ctx, 1);
+void UnaryFunction<Functor>::Compile(Handle<Object> ctx, Compiler* compiler) {
+    compiler->EmitConstant(GetArgs(ctx, 1)[0]);
+    compiler->EmitApply(this, 1);
+}
 
-    auto number = As<Number>(As<Cell>(ctx)->GetFirst());
-    if (!number) {
+template <class Functor>
+Value UnaryFunction<Functor>::Apply(std::span<Value> args) {
+    if (!IsNumber(args[0])) {
         throw RuntimeError("Expected number as arg!");
     }
-    return std::make_shared<Number>(Functor{}(number->GetValue()));
+    return Compute<Functor>(args[0]);
 }
 
-static std::vector<int64_t> GetValues(std::shared_ptr<const Cell> cell) {
-    if (!cell) {
+// Args of numeric functions: numbers are taken as they are, lists are evaluated.
+static ArgList GetNumericArgs(const Handle<Object>& ctx) {
+    if (!Is<Cell>(ctx)) {
         return {};
     }
-    auto args = Flatten(*cell);
-    if (args.back() != nullptr) {
+    Handle<Object> tail;
+    auto args = Collect(ctx, &tail);
+    if (tail != nullptr) {
         throw RuntimeError("Args are not a proper list!");
     }
-    args.pop_back();  // remove nullptr
-    if (!std::ranges::all_of(args, [](std::shared_ptr<Object> object) {
-            return Is<Number>(object) || Is<Cell>(object);
+    if (!std::ranges::all_of(args, [](const Handle<Object>& object) {
+            return Is<Number>(object) || Is<BigNumber>(object) || Is<Cell>(object);
         })) {
         throw RuntimeError("Args are not numbers!");
     }
-    std::vector<int64_t> values;
-    values.reserve(args.size());
-    std::ranges::transform(args, std::back_inserter(values), [](std::shared_ptr<Object> object) {
-        if (Is<Cell>(object)) {
-            auto val = As<Number>(object->Evaluate());
-            if (!val) {
-                throw RuntimeError("Args are not numbers!");
-            }
-            return val->GetValue();
-        }
-        return As<Number>(object)->GetValue();
-    });
+    return args;
+}
+
+static SmallVector<Value, 8> EvaluateNumericArgs(const Handle<Object>& ctx) {
+    SmallVector<Value, 8> values;
+    for (const auto& arg : GetNumericArgs(ctx)) {
+        values.emplace_back(Is<Cell>(arg) ? arg->Evaluate() : arg);
+    }
     return values;
 }
 
+static size_t CompileNumericArgs(const Handle<Object>& ctx, Compiler* compiler) {
+    auto args = GetNumericArgs(ctx);
+    for (const auto& arg : args) {
+        if (Is<Cell>(arg)) {
+            compiler->EmitEvaluate(arg);
+        } else {
+            compiler->EmitConstant(arg);
+        }
+    }
+    return args.size();
+}
+
+static void CheckNumber(const Value& value) {
+    if (!IsNumber(value)) {
+        throw RuntimeError("Args are not numbers!");
+    }
+}
+
 template <class Cmp>
-std::shared_ptr<Object> CmpFunction<Cmp>::Evaluate(std::shared_ptr<Object> ctx) {
-    auto values = GetValues(As<const Cell>(ctx));
+Handle<Object> CmpFunction<Cmp>::Evaluate(Handle<Object> ctx) {
+    return Apply(EvaluateNumericArgs(ctx)).ToObject();
+}
+
+template <class Cmp>
+void CmpFunction<Cmp>::Compile(Handle<Object> ctx, Compiler* compiler) {
+    compiler->EmitApply(this, CompileNumericArgs(ctx, compiler));
+}
+
+template <class Cmp>
+Value CmpFunction<Cmp>::Apply(std::span<Value> args) {
     bool ans = true;
-    for (size_t i = 0; i + 1 < values.size(); ++i) {
-        if (!Cmp{}(values[i], values[i + 1])) {
+    for (size_t i = 0; i < args.size(); ++i) {
+        CheckNumber(args[i]);
+        if (i > 0 && ans && !Cmp{}(Compare(args[i - 1], args[i]), 0)) {
             ans = false;
         }
     }
-    return std::make_shared<Symbol>(ans);
+    return Value::Boolean(ans);
+}
+
+template <int64_t start_value, class Functor>
+Handle<Object> FoldFunction<start_value, Functor>::Evaluate(Handle<Object> ctx) {
+    return Apply(EvaluateNumericArgs(ctx)).ToObject();
+}
+
+template <int64_t start_value, class Functor>
+void FoldFunction<start_value, Functor>::Compile(Handle<Object> ctx, Compiler* compiler) {
+    compiler->EmitApply(this, CompileNumericArgs(ctx, compiler));
 }
 
 template <int64_t start_value, class Functor>
-std::shared_ptr<Object> FoldFunction<start_value, Functor>::Evaluate(std::shared_ptr<Object> ctx) {
-    auto values = GetValues(As<const Cell>(ctx));
-    return std::make_shared<Number>(
-        std::accumulate(values.begin(), values.end(), start_value, Functor{}));
+Value FoldFunction<start_value, Functor>::Apply(std::span<Value> args) {
+    auto ans = Value::Fixnum(start_value);
+    for (const auto& arg : args) {
+        ans = Compute<Functor>(ans, arg);
+    }
+    return ans;
 }
 
 template <bool start_value, class Functor>
-std::shared_ptr<Object> LogicFunction<start_value, Functor>::Evaluate(std::shared_ptr<Object> ctx) {
+Handle<Object> LogicFunction<start_value, Functor>::Evaluate(Handle<Object> ctx) {
     if (!Is<Cell>(ctx)) {
-        return std::make_shared<Symbol>(start_value);
+        return Symbol::GetBoolean(start_value);
     }
-    auto args = Flatten(*As<Cell>(ctx));
-    if (args.back() != nullptr) {
+    Handle<Object> tail;
+    auto args = Collect(ctx, &tail);
+    if (tail != nullptr) {
         throw RuntimeError("Args are not a proper list!");
     }
-    args.pop_back();  // remove nullptr
+    Handle<Object> ans;
     for (const auto& arg : args) {
-        if (Functor{}(static_cast<bool>(*arg->Evaluate()), start_value) != start_value) {
-            return arg->Evaluate();
+        ans = EvaluateArg(arg);
+        if (Functor{}(!ans || static_cast<bool>(*ans), start_value) != start_value) {
+            return ans;
+        }
+    }
+    return ans;
+}
+
+template <bool start_value, class Functor>
+void LogicFunction<start_value, Functor>::Compile(Handle<Object> ctx, Compiler* compiler) {
+    if (!Is<Cell>(ctx)) {
+        compiler->EmitConstant(Symbol::GetBoolean(start_value));
+        return;
+    }
+    Handle<Object> tail;
+    auto args = Collect(ctx, &tail);
+    if (tail != nullptr) {
+        throw RuntimeError("Args are not a proper list!");
+    }
+
+    // The first arg that breaks the chain is the result, the last one otherwise.
+    auto end = compiler->NewLabel();
+    for (size_t i = 0; i < args.size(); ++i) {
+        compiler->EmitEvaluate(args[i]);
+        if (i + 1 != args.size()) {
+            compiler->EmitJump(
+                start_value ? Opcode::JUMP_IF_FALSE_OR_POP : Opcode::JUMP_IF_TRUE_OR_POP, end);
         }
     }
-    return args.back()->Evaluate();
+    compiler->BindLabel(end);
 }
 
 template <class Functor>
-std::shared_ptr<Object> BinaryFunction<Functor>::Evaluate(std::shared_ptr<Object> ctx) {
-    auto values = GetValues(As<const Cell>(ctx));
+Handle<Object> BinaryFunction<Functor>::Evaluate(Handle<Object> ctx) {
+    auto values = EvaluateNumericArgs(ctx);
     if (values.empty()) {
         throw RuntimeError("Not enough args!");
     }
-    return std::make_shared<Number>(
-        std::accumulate(std::next(values.begin()), values.end(), values.front(), Functor{}));
+    return Apply(values).ToObject();
+}
+
+template <class Functor>
+void BinaryFunction<Functor>::Compile(Handle<Object> ctx, Compiler* compiler) {
+    auto amount = CompileNumericArgs(ctx, compiler);
+    if (amount == 0) {
+        throw RuntimeError("Not enough args!");
+    }
+    compiler->EmitApply(this, amount);
+}
+
+template <class Functor>
+Value BinaryFunction<Functor>::Apply(std::span<Value> args) {
+    CheckNumber(args.front());
+    auto ans = args.front();
+    for (const auto& arg : args.subspan(1)) {
+        ans = Compute<Functor>(ans, arg);
+    }
+    return ans;
 }
 
-std::shared_ptr<Object> Cell::Evaluate(std::shared_ptr<Object>) {
+Handle<Object> Cell::Evaluate(Handle<Object>) {
     auto symbol = As<Symbol>(GetFirst());
     if (!(symbol && symbol->IsFunction())) {
         throw RuntimeError("Lists (without functors) are not evaluatable!");
     }
+    SCHEME_PROFILE_CALL(symbol->GetId(), position_);
     return symbol->Evaluate(GetSecond());
 };
@@ -1,19 +1,55 @@
 #pragma once
 
 #include <array>
+#include <charconv>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <iterator>
+#include <limits>
 #include <memory>
-
-class Object : public std::enable_shared_from_this<Object> {
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bigint.h"
+#include "heap.h"
+#include "small_vector.h"
+#include "source_position.h"
+#include "symbol_table.h"
+
+class Compiler;
+class Function;
+class Object;
+class Value;
+
+// Argument lists are short, so they are collected into an inline buffer.
+using ArgList = SmallVector<Handle<Object>, 8>;
+
+// Scheme objects are always created on a Heap (see New) and referred to by
+// handles.
+class Object {
 public:
-    virtual std::shared_ptr<Object> Evaluate(std::shared_ptr<Object> ctx = nullptr) = 0;
-    virtual std::string Serialize() = 0;
+    virtual Handle<Object> Evaluate(Handle<Object> ctx = nullptr) = 0;
+
+    // Appends the external representation to |out|.
+    virtual void SerializeTo(std::string* out) = 0;
+
+    std::string Serialize() {
+        std::string out;
+        SerializeTo(&out);
+        return out;
+    }
+
     explicit virtual operator bool() {
         return true;
     };
 
+    // Appends the objects this one refers to to |children|, for the collector.
+    virtual void Trace(std::vector<Object*>*) const {
+    }
+
     virtual ~Object() = default;
 };
 
@@ -26,12 +62,14 @@ public:
         return number_;
     }
 
-    std::shared_ptr<Object> Evaluate(std::shared_ptr<Object>) override {
-        return std::make_shared<Number>(number_);
+    Handle<Object> Evaluate(Handle<Object>) override {
+        return Handle<Object>(this);
     };
 
-    std::string Serialize() override {
-        return std::to_string(number_);
+    void SerializeTo(std::string* out) override {
+        char buffer[std::numeric_limits<int64_t>::digits10 + 2];
+        auto [end, error] = std::to_chars(std::begin(buffer), std::end(buffer), number_);
+        out->append(buffer, end);
     }
 
     virtual ~Number() = default;
@@ -40,204 +78,358 @@ private:
     int64_t number_;
 };
 
+// Integer that doesn't fit into Number. Arithmetic only produces it on overflow.
+class BigNumber : public Object {
+public:
+    explicit BigNumber(BigInteger number) : number_(std::move(number)) {
+    }
+
+    const BigInteger& GetValue() const {
+        return number_;
+    }
+
+    Handle<Object> Evaluate(Handle<Object>) override {
+        return Handle<Object>(this);
+    };
+
+    void SerializeTo(std::string* out) override {
+        out->append(number_.ToString());
+    }
+
+private:
+    BigInteger number_;
+};
+
 class Symbol : public Object {
 public:
-    explicit Symbol(std::string name) : name_(std::move(name)) {
+    explicit Symbol(std::string_view name) : Symbol(Intern(name)) {
+    }
+    explicit Symbol(SymbolId id) : id_(id), name_(&SymbolTable::Instance().GetName(id)) {
     }
-    explicit Symbol(bool value) : name_(value ? "#t" : "#f") {
+
+    // #t and #f are shared singletons, which are never freed.
+    static Handle<Symbol> GetBoolean(bool value);
+
+    SymbolId GetId() const {
+        return id_;
     }
 
     const std::string& GetName() const {
-        return name_;
+        return *name_;
     }
 
-    std::shared_ptr<Object> Evaluate(std::shared_ptr<Object> ctx) override;
+    bool IsBoolean() const;
+
+    Handle<Object> Evaluate(Handle<Object> ctx) override;
     bool IsFunction() const;
+    Function* GetFunction() const;
 
-    std::string Serialize() override {
-        return GetName();
+    void SerializeTo(std::string* out) override {
+        out->append(GetName());
     }
 
-    explicit operator bool() override {
-        return name_ != "#f";
-    }
+    explicit operator bool() override;
 
 private:
-    std::string name_;
+    SymbolId id_;
+    const std::string* name_;
 };
 
 class Function {
 public:
-    Function(std::string name) : name_(std::move(name)) {
+    Function(std::string name) : id_(Intern(name)), name_(std::move(name)) {
     }
     bool Check(const Symbol& symbol) {
-        return symbol.GetName() == name_;
+        return symbol.GetId() == id_;
+    }
+    SymbolId GetId() const {
+        return id_;
+    }
+    virtual Handle<Object> Evaluate(Handle<Object> ctx) = 0;
+
+    // Lowers a call with the unevaluated |ctx| into bytecode. By default the call
+    // is left to the tree-walking Evaluate.
+    virtual void Compile(Handle<Object> ctx, Compiler* compiler);
+
+    // Applies the function to already evaluated arguments, used by Vm.
+    virtual Value Apply(std::span<Value> args);
+
+    // Which args of a call are evaluated before the function sees them, the
+    // rest are taken as they are written.
+    enum class ArgPolicy { NONE, ALL, FIRST };
+    virtual ArgPolicy GetArgPolicy() const {
+        return ArgPolicy::NONE;
     }
-    virtual std::shared_ptr<Object> Evaluate(std::shared_ptr<Object> ctx) = 0;
 
     virtual ~Function() = default;
 
-    static const std::array<std::unique_ptr<Function>, 27> kFunctions;
+    static const std::array<std::unique_ptr<Function>, 28> kFunctions;
 
 protected:
-    void CheckCtx(std::shared_ptr<Object> ctx);
-    void CheckAmountOfArgs(std::shared_ptr<Object> ctx, size_t args);
+    void CheckCtx(Handle<Object> ctx);
+
+    // Collects the args of a call, checking that they form a proper list of
+    // |args| elements.
+    ArgList GetArgs(Handle<Object> ctx, size_t args);
+
+    // Evaluates |args| args of a call and applies the function to them.
+    Handle<Object> EvaluateApply(Handle<Object> ctx, size_t args);
+    void CompileApply(Handle<Object> ctx, size_t args, Compiler* compiler);
 
 private:
+    SymbolId id_;
     std::string name_;
 };
 
 class QuoteFunction : public Function {
     using Function::Function;
 
-    std::shared_ptr<Object> Evaluate(std::shared_ptr<Object> ctx) override;
+    Handle<Object> Evaluate(Handle<Object> ctx) override;
+    void Compile(Handle<Object> ctx, Compiler* compiler) override;
 };
 
 class IsBooleanFunction : public Function {
     using Function::Function;
 
-    std::shared_ptr<Object> Evaluate(std::shared_ptr<Object> ctx) override;
+    Handle<Object> Evaluate(Handle<Object> ctx) override;
+    void Compile(Handle<Object> ctx, Compiler* compiler) override;
+    Value Apply(std::span<Value> args) override;
+    ArgPolicy GetArgPolicy() const override {
+        return ArgPolicy::ALL;
+    }
 };
 
 class IsNumberFunction : public Function {
     using Function::Function;
 
-    std::shared_ptr<Object> Evaluate(std::shared_ptr<Object> ctx) override;
+    Handle<Object> Evaluate(Handle<Object> ctx) override;
+    void Compile(Handle<Object> ctx, Compiler* compiler) override;
 };
 
 class IsPairFunction : public Function {
     using Function::Function;
 
-    std::shared_ptr<Object> Evaluate(std::shared_ptr<Object> ctx) override;
+    Handle<Object> Evaluate(Handle<Object> ctx) override;
+    void Compile(Handle<Object> ctx, Compiler* compiler) override;
+    Value Apply(std::span<Value> args) override;
+    ArgPolicy GetArgPolicy() const override {
+        return ArgPolicy::ALL;
+    }
 };
 
 class IsNullFunction : public Function {
     using Function::Function;
 
-    std::shared_ptr<Object> Evaluate(std::shared_ptr<Object> ctx) override;
+    Handle<Object> Evaluate(Handle<Object> ctx) override;
+    void Compile(Handle<Object> ctx, Compiler* compiler) override;
+    Value Apply(std::span<Value> args) override;
+    ArgPolicy GetArgPolicy() const override {
+        return ArgPolicy::ALL;
+    }
 };
 
 class IsListFunction : public Function {
     using Function::Function;
 
-    std::shared_ptr<Object> Evaluate(std::shared_ptr<Object> ctx) override;
+    Handle<Object> Evaluate(Handle<Object> ctx) override;
+    void Compile(Handle<Object> ctx, Compiler* compiler) override;
+    Value Apply(std::span<Value> args) override;
+    ArgPolicy GetArgPolicy() const override {
+        return ArgPolicy::ALL;
+    }
 };
 
 class NotFunction : public Function {
     using Function::Function;
 
-    std::shared_ptr<Object> Evaluate(std::shared_ptr<Object> ctx) override;
+    Handle<Object> Evaluate(Handle<Object> ctx) override;
+    void Compile(Handle<Object> ctx, Compiler* compiler) override;
+    Value Apply(std::span<Value> args) override;
+    ArgPolicy GetArgPolicy() const override {
+        return ArgPolicy::ALL;
+    }
 };
 
 class ConsFunction : public Function {
     using Function::Function;
 
-    std::shared_ptr<Object> Evaluate(std::shared_ptr<Object> ctx) override;
+    Handle<Object> Evaluate(Handle<Object> ctx) override;
+    void Compile(Handle<Object> ctx, Compiler* compiler) override;
+    Value Apply(std::span<Value> args) override;
 };
 
 class CarFunction : public Function {
     using Function::Function;
 
-    std::shared_ptr<Object> Evaluate(std::shared_ptr<Object> ctx) override;
+    Handle<Object> Evaluate(Handle<Object> ctx) override;
+    void Compile(Handle<Object> ctx, Compiler* compiler) override;
+    Value Apply(std::span<Value> args) override;
+    ArgPolicy GetArgPolicy() const override {
+        return ArgPolicy::ALL;
+    }
 };
 
 class CdrFunction : public Function {
     using Function::Function;
 
-    std::shared_ptr<Object> Evaluate(std::shared_ptr<Object> ctx) override;
+    Handle<Object> Evaluate(Handle<Object> ctx) override;
+    void Compile(Handle<Object> ctx, Compiler* compiler) override;
+    Value Apply(std::span<Value> args) override;
+    ArgPolicy GetArgPolicy() const override {
+        return ArgPolicy::ALL;
+    }
 };
 
 class ListFunction : public Function {
     using Function::Function;
 
-    std::shared_ptr<Object> Evaluate(std::shared_ptr<Object> ctx) override;
+    Handle<Object> Evaluate(Handle<Object> ctx) override;
+    void Compile(Handle<Object> ctx, Compiler* compiler) override;
 };
 
 class ListRefFunction : public Function {
     using Function::Function;
 
-    std::shared_ptr<Object> Evaluate(std::shared_ptr<Object> ctx) override;
+    Handle<Object> Evaluate(Handle<Object> ctx) override;
+    void Compile(Handle<Object> ctx, Compiler* compiler) override;
+    Value Apply(std::span<Value> args) override;
+    ArgPolicy GetArgPolicy() const override {
+        return ArgPolicy::FIRST;
+    }
 };
 
 class ListTailFunction : public Function {
     using Function::Function;
 
-    std::shared_ptr<Object> Evaluate(std::shared_ptr<Object> ctx) override;
+    Handle<Object> Evaluate(Handle<Object> ctx) override;
+    void Compile(Handle<Object> ctx, Compiler* compiler) override;
+    Value Apply(std::span<Value> args) override;
+    ArgPolicy GetArgPolicy() const override {
+        return ArgPolicy::FIRST;
+    }
+};
+
+// Structural equality. Identical objects, e.g. hash-consed data, are equal
+// without looking inside.
+class EqualFunction : public Function {
+    using Function::Function;
+
+    Handle<Object> Evaluate(Handle<Object> ctx) override;
+    void Compile(Handle<Object> ctx, Compiler* compiler) override;
+    Value Apply(std::span<Value> args) override;
+    ArgPolicy GetArgPolicy() const override {
+        return ArgPolicy::ALL;
+    }
 };
 
 template <bool start_value, class Functor>
 class LogicFunction : public Function {
     using Function::Function;
 
-    std::shared_ptr<Object> Evaluate(std::shared_ptr<Object> ctx) override;
+    Handle<Object> Evaluate(Handle<Object> ctx) override;
+    void Compile(Handle<Object> ctx, Compiler* compiler) override;
+    ArgPolicy GetArgPolicy() const override {
+        return ArgPolicy::ALL;
+    }
 };
 
 template <class Functor>
 class UnaryFunction : public Function {
     using Function::Function;
 
-    std::shared_ptr<Object> Evaluate(std::shared_ptr<Object> ctx) override;
+    Handle<Object> Evaluate(Handle<Object> ctx) override;
+    void Compile(Handle<Object> ctx, Compiler* compiler) override;
+    Value Apply(std::span<Value> args) override;
 };
 
 template <class Cmp>
 class CmpFunction : public Function {
     using Function::Function;
 
-    std::shared_ptr<Object> Evaluate(std::shared_ptr<Object> ctx) override;
+    Handle<Object> Evaluate(Handle<Object> ctx) override;
+    void Compile(Handle<Object> ctx, Compiler* compiler) override;
+    Value Apply(std::span<Value> args) override;
+    ArgPolicy GetArgPolicy() const override {
+        return ArgPolicy::ALL;
+    }
 };
 
 template <int64_t start_value, class Functor>
 class FoldFunction : public Function {
     using Function::Function;
 
-    std::shared_ptr<Object> Evaluate(std::shared_ptr<Object> ctx) override;
+    Handle<Object> Evaluate(Handle<Object> ctx) override;
+    void Compile(Handle<Object> ctx, Compiler* compiler) override;
+    Value Apply(std::span<Value> args) override;
+    ArgPolicy GetArgPolicy() const override {
+        return ArgPolicy::ALL;
+    }
 };
 
 template <class Functor>
 class BinaryFunction : public Function {
     using Function::Function;
 
-    std::shared_ptr<Object> Evaluate(std::shared_ptr<Object> ctx) override;
+    Handle<Object> Evaluate(Handle<Object> ctx) override;
+    void Compile(Handle<Object> ctx, Compiler* compiler) override;
+    Value Apply(std::span<Value> args) override;
+    ArgPolicy GetArgPolicy() const override {
+        return ArgPolicy::ALL;
+    }
 };
 
-template class BinaryFunction<std::minus<int64_t>>;
-template class BinaryFunction<std::divides<int64_t>>;
-
 class Cell : public Object {
 public:
-    Cell(std::shared_ptr<Object> first = {}, std::shared_ptr<Object> second = {})
+    Cell(Handle<Object> first = {}, Handle<Object> second = {})
         : first_(first), second_(second) {
     }
 
-    std::shared_ptr<Object> GetFirst() const {
+    Handle<Object> GetFirst() const {
         return first_;
     }
-    std::shared_ptr<Object> GetSecond() const {
+    Handle<Object> GetSecond() const {
         return second_;
     }
 
-    std::shared_ptr<Object> Evaluate(std::shared_ptr<Object>) override;
+    Handle<Object> Evaluate(Handle<Object>) override;
 
-    std::string Serialize() override;
+    // Writes nested lists of any depth in a single pass without recursion.
+    void SerializeTo(std::string* out) override;
 
-    virtual ~Cell() = default;
+    void Trace(std::vector<Object*>* children) const override {
+        children->push_back(first_.get());
+        children->push_back(second_.get());
+    }
+
+#ifdef SCHEME_PROFILING
+    // Where the list starts in the source, only tracked for the profiler and
+    // left unset for hash-consed cells.
+    const SourcePosition& GetPosition() const {
+        return position_;
+    }
+    void SetPosition(const SourcePosition& position) {
+        position_ = position;
+    }
+#endif
 
 private:
-    std::shared_ptr<Object> first_;
-    std::shared_ptr<Object> second_;
+    Handle<Object> first_;
+    Handle<Object> second_;
+#ifdef SCHEME_PROFILING
+    SourcePosition position_;
+#endif
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
 // Runtime type checking and conversion.
-// This can be helpful: https://en.cppreference.com/w/cpp/memory/shared_ptr/pointer_cast
 
 template <class T>
-std::shared_ptr<T> As(const std::shared_ptr<Object>& obj) {
-    return std::dynamic_pointer_cast<T>(obj);
+Handle<T> As(Handle<Object> obj) {
+    return Handle<T>(dynamic_cast<T*>(obj.get()));
 }
 
 template <class T>
-bool Is(const std::shared_ptr<Object>& obj) {
+bool Is(Handle<Object> obj) {
     return dynamic_cast<T*>(obj.get());
 }
@@ -0,0 +1,144 @@
+#include "optimizer.h"
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "object.h"
+
+namespace {
+
+const SymbolId kQuoteId = Intern("quote");
+
+Function* GetCallee(const Handle<Object>& obj) {
+    auto cell = As<Cell>(obj);
+    if (!cell) {
+        return nullptr;
+    }
+    auto symbol = As<Symbol>(cell->GetFirst());
+    return symbol ? symbol->GetFunction() : nullptr;
+}
+
+bool IsQuote(const Handle<Object>& obj) {
+    auto function = GetCallee(obj);
+    return function && function->GetId() == kQuoteId;
+}
+
+// Objects that evaluate to themselves without doing anything else.
+bool IsLiteral(const Handle<Object>& obj) {
+    if (Is<Number>(obj) || Is<BigNumber>(obj) || IsQuote(obj)) {
+        return true;
+    }
+    auto symbol = As<Symbol>(obj);
+    return symbol && !symbol->IsFunction();
+}
+
+bool IsEvaluated(Function::ArgPolicy policy, size_t idx) {
+    return policy == Function::ArgPolicy::ALL ||
+           (policy == Function::ArgPolicy::FIRST && idx == 0);
+}
+
+// Rewritten calls keep their call site for the profiler.
+Handle<Cell> MakeCall([[maybe_unused]] const Cell& call, Handle<Object> head, Handle<Object> args) {
+    auto ans = New<Cell>(std::move(head), std::move(args));
+#ifdef SCHEME_PROFILING
+    ans->SetPosition(call.GetPosition());
+#endif
+    return ans;
+}
+
+// A call keeps its shape, so numbers stay numbers and anything else becomes a
+// quoted list, which is what a builtin would have seen after evaluating it.
+Handle<Object> MakeLiteral(const Cell& call, Handle<Object> value) {
+    if (Is<Number>(value) || Is<BigNumber>(value)) {
+        return value;
+    }
+    return MakeCall(call, New<Symbol>(kQuoteId), New<Cell>(std::move(value)));
+}
+
+struct Frame {
+    Handle<Cell> call;
+    Function* function = nullptr;
+    std::vector<Handle<Object>> args;
+    size_t next = 0;
+    bool changed = false;
+};
+
+Frame MakeFrame(const Handle<Object>& call) {
+    Frame frame;
+    frame.call = As<Cell>(call);
+    frame.function = GetCallee(call);
+    auto cur = frame.call->GetSecond();
+    while (auto cell = As<Cell>(cur)) {
+        frame.args.push_back(cell->GetFirst());
+        cur = cell->GetSecond();
+    }
+    // Improper arg lists are left for the evaluator to reject.
+    if (cur) {
+        frame.args.clear();
+    }
+    return frame;
+}
+
+}  // namespace
+
+Handle<Object> Optimizer::Optimize(const Handle<Object>& ast) {
+    if (!GetCallee(ast)) {
+        return ast;
+    }
+
+    // Post-order walk over the calls in evaluated positions with an explicit
+    // stack, so deeply nested programs don't exhaust the native one.
+    std::vector<Frame> stack;
+    stack.push_back(MakeFrame(ast));
+    Handle<Object> ans;
+    while (!stack.empty()) {
+        auto& frame = stack.back();
+        auto policy = frame.function->GetArgPolicy();
+        while (frame.next < frame.args.size() &&
+               !(IsEvaluated(policy, frame.next) && GetCallee(frame.args[frame.next]))) {
+            ++frame.next;
+        }
+        if (frame.next < frame.args.size()) {
+            stack.push_back(MakeFrame(frame.args[frame.next]));
+            continue;
+        }
+
+        bool foldable = true;
+        for (size_t i = 0; i < frame.args.size(); ++i) {
+            foldable &= !IsEvaluated(policy, i) || IsLiteral(frame.args[i]);
+        }
+
+        Handle<Object> node = frame.call;
+        if (frame.changed) {
+            Handle<Object> args;
+            for (auto it = frame.args.rbegin(); it != frame.args.rend(); ++it) {
+                args = New<Cell>(std::move(*it), std::move(args));
+            }
+            node = MakeCall(*frame.call, frame.call->GetFirst(), std::move(args));
+        }
+
+        if (foldable) {
+            try {
+                auto literal = MakeLiteral(*frame.call, node->Evaluate());
+                if (!(IsQuote(node) && IsQuote(literal))) {
+                    node = std::move(literal);
+                    ++folded_;
+                }
+            } catch (const std::runtime_error&) {
+                // Keep the call, it raises its error when it's evaluated.
+            }
+        }
+
+        stack.pop_back();
+        if (stack.empty()) {
+            ans = std::move(node);
+        } else {
+            auto& parent = stack.back();
+            if (node != parent.args[parent.next]) {
+                parent.args[parent.next] = std::move(node);
+                parent.changed = true;
+            }
+            ++parent.next;
+        }
+    }
+    return ans;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include "heap.h"
+
+class Object;
+
+// Constant folding pass run between Read and evaluation. The language has no
+// variables, so every builtin call whose evaluated args are literals can be
+// replaced with its value. Calls that fail are kept, so their errors are still
+// raised only if they are reached at runtime. Args that a builtin takes as
+// written (see Function::ArgPolicy) are never touched.
+//
+// Thread-safe, one optimizer can be shared by many interpreters.
+class Optimizer {
+public:
+    Handle<Object> Optimize(const Handle<Object>& ast);
+
+    // Total amount of calls replaced with literals.
+    size_t GetFolded() const {
+        return folded_;
+    }
+
+private:
+    std::atomic<size_t> folded_ = 0;
+};
@@ -1,112 +1,205 @@
 #include <parser.h>
 #include <cstddef>
 #include <memory>
+#include <utility>
 #include <variant>
 #include <vector>
 #include "error.h"
+#include "hash_cons.h"
 #include "object.h"
 #include "tokenizer.h"
-std::shared_ptr<Object> ReadList(Tokenizer* tokenizer);
+
+namespace {
 
 template <class... Ts>
 struct Overloaded : Ts... {
     using Ts::operator()...;
 };
 
-std::shared_ptr<Object> Read(Tokenizer* tokenizer) {
-    if (tokenizer->IsEnd()) {
-        throw SyntaxError("empty!");
+bool IsCloseBracket(const Token& token) {
+    if (auto bracket = std::get_if<BracketToken>(&token)) {
+        return *bracket == BracketToken::CLOSE;
     }
-    return std::visit(
-        Overloaded{
-            [tokenizer](const BracketToken& token) -> std::shared_ptr<Object> {
-                if (token == BracketToken::OPEN) {
-                    tokenizer->Next();  // Skip open bracket
-                    auto ans = ReadList(tokenizer);
-                    tokenizer->Next();  // Skip close bracket
-                    return ans;
-                }
-                throw SyntaxError("closing bracket before, opening!");
-            },
-            [tokenizer](const ConstantToken& token) -> std::shared_ptr<Object> {
-                tokenizer->Next();
-                return std::make_shared<Number>(token.value);
-            },
-            [tokenizer](const SymbolToken& token) -> std::shared_ptr<Object> {
-                tokenizer->Next();
-                return std::make_shared<Symbol>(token.name);
-            },
-            [tokenizer](const QuoteToken&) -> std::shared_ptr<Object> {
-                tokenizer->Next();
-                return std::make_shared<Cell>(std::make_shared<Symbol>(std::string("quote")),
-                                              std::make_shared<Cell>(Read(tokenizer)));
-            },
-            [](const auto&) -> std::shared_ptr<Object> { throw SyntaxError("syntax error!"); }},
-        tokenizer->GetToken());
+    return false;
 }
 
-std::shared_ptr<Object> ReadList(Tokenizer* tokenizer) {
-    if (tokenizer->IsEnd()) {
-        throw SyntaxError("No end bracket!");
+// Objects are shared through |conser| if it's set, otherwise always allocated.
+Handle<Cell> MakeCell(HashConser* conser, Handle<Object> first, Handle<Object> second = nullptr) {
+    if (conser) {
+        return conser->MakeCell(std::move(first), std::move(second));
     }
+    return New<Cell>(std::move(first), std::move(second));
+}
 
-    auto is_close_bracket = [](const Token& token) {
-        if (auto bracket = std::get_if<BracketToken>(&token)) {
-            return *bracket == BracketToken::CLOSE;
-        }
-        return false;
-    };
-
-    if (is_close_bracket(tokenizer->GetToken())) {
-        return nullptr;
+Handle<Object> MakeNumber(HashConser* conser, int64_t value) {
+    if (conser) {
+        return conser->MakeNumber(value);
     }
+    return New<Number>(value);
+}
 
-    std::vector<std::shared_ptr<Object>> elements;
+Handle<Object> MakeSymbol(HashConser* conser, std::string_view name) {
+    if (conser) {
+        return conser->MakeSymbol(name);
+    }
+    return New<Symbol>(name);
+}
 
+// A list or a quote whose elements are still being read.
+struct Frame {
+    bool is_quote = false;
+    std::vector<Handle<Object>> elements;
     size_t amount_of_dots = 0;
     bool add_empty = true;
-    while (!is_close_bracket(tokenizer->GetToken())) {
-        add_empty = !std::holds_alternative<DotToken>(tokenizer->GetToken());
+#ifdef SCHEME_PROFILING
+    SourcePosition position;  // of the open bracket or the quote
+#endif
+};
 
-        if (std::holds_alternative<DotToken>(tokenizer->GetToken())) {
-            ++amount_of_dots;
-            tokenizer->Next();
-        }
+// Remembers where the list of |frame| starts, so the profiler can attribute
+// calls to their call sites.
+void SetPosition([[maybe_unused]] Frame* frame, [[maybe_unused]] Tokenizer* tokenizer) {
+#ifdef SCHEME_PROFILING
+    frame->position = tokenizer->GetPosition();
+#endif
+}
+
+// Hash-consed cells are shared with other readers, possibly on other threads,
+// so they are never written to and have no position.
+void SetPosition([[maybe_unused]] Cell* cell, [[maybe_unused]] const Frame& frame,
+                 [[maybe_unused]] HashConser* conser) {
+#ifdef SCHEME_PROFILING
+    if (!conser) {
+        cell->SetPosition(frame.position);
+    }
+#endif
+}
 
-        elements.push_back(Read(tokenizer));
+// Consumes an optional dot in front of the next element of |frame|.
+void StartElement(Tokenizer* tokenizer, Frame* frame) {
+    frame->add_empty = !std::holds_alternative<DotToken>(tokenizer->GetToken());
 
-        if (tokenizer->IsEnd()) {
-            throw SyntaxError{"No closing bracket!"};
-        }
+    if (!frame->add_empty) {
+        ++frame->amount_of_dots;
+        tokenizer->Next();
     }
+}
+
+Handle<Object> FinishList(Frame* frame, HashConser* conser) {
+    auto& elements = frame->elements;
 
     /* checking corrrectness */
-    if (amount_of_dots != 0) {                           // if not proper list
-        if (amount_of_dots != 1 || add_empty == true) {  // if not improper list
+    if (frame->amount_of_dots != 0) {                                  // if not proper list
+        if (frame->amount_of_dots != 1 || frame->add_empty == true) {  // if not improper list
             throw SyntaxError{"Incorrect dots placement!"};
         }
     }
 
-    if (add_empty && elements.empty()) {
+    if (frame->add_empty && elements.empty()) {
         throw SyntaxError{"Incorrect list!"};
     }
-    if (!add_empty && elements.size() < 2) {
+    if (!frame->add_empty && elements.size() < 2) {
         throw SyntaxError{"Incorrect list!"};
     }
 
-    std::shared_ptr<Cell> answer;
-    if (add_empty) {
-        answer = std::make_shared<Cell>(elements.back());
+    Handle<Cell> answer;
+    if (frame->add_empty) {
+        answer = MakeCell(conser, elements.back());
         elements.pop_back();
     } else {
-        answer =
-            std::make_shared<Cell>(elements[elements.size() - 2], elements[elements.size() - 1]);
+        answer = MakeCell(conser, elements[elements.size() - 2], elements[elements.size() - 1]);
         elements.resize(elements.size() - 2);
     }
     while (!elements.empty()) {
-        answer = std::make_shared<Cell>(elements.back(), answer);
+        answer = MakeCell(conser, elements.back(), answer);
         elements.pop_back();
     }
 
+    SetPosition(answer.get(), *frame, conser);
     return answer;
-}
\ No newline at end of file
+}
+
+}  // namespace
+
+Handle<Object> Read(Tokenizer* tokenizer, HashConser* conser) {
+    std::vector<Frame> frames;
+
+    while (true) {
+        if (tokenizer->IsEnd()) {
+            throw SyntaxError(frames.empty() ? "empty!" : "No closing bracket!");
+        }
+
+        // Either a complete datum or a new frame pushed.
+        using Result = std::pair<Handle<Object>, bool>;
+        auto [datum, is_complete] = std::visit(
+            Overloaded{
+                [tokenizer, &frames](const BracketToken& token) -> Result {
+                    if (token != BracketToken::OPEN) {
+                        throw SyntaxError("closing bracket before, opening!");
+                    }
+                    Frame frame;
+                    SetPosition(&frame, tokenizer);
+                    tokenizer->Next();  // Skip open bracket
+                    if (tokenizer->IsEnd()) {
+                        throw SyntaxError("No end bracket!");
+                    }
+                    if (IsCloseBracket(tokenizer->GetToken())) {
+                        tokenizer->Next();  // Skip close bracket
+                        return {nullptr, true};
+                    }
+                    StartElement(tokenizer, &frames.emplace_back(std::move(frame)));
+                    return {nullptr, false};
+                },
+                [tokenizer, conser](const ConstantToken& token) -> Result {
+                    tokenizer->Next();
+                    return {MakeNumber(conser, token.value), true};
+                },
+                [tokenizer, conser](const SymbolToken& token) -> Result {
+                    tokenizer->Next();
+                    return {MakeSymbol(conser, token.name), true};
+                },
+                [tokenizer, &frames](const QuoteToken&) -> Result {
+                    Frame frame;
+                    frame.is_quote = true;
+                    SetPosition(&frame, tokenizer);
+                    tokenizer->Next();
+                    frames.push_back(std::move(frame));
+                    return {nullptr, false};
+                },
+                [](const DotToken&) -> Result {
+                    throw SyntaxError("syntax error!");
+                }},
+            tokenizer->GetToken());
+        if (!is_complete) {
+            continue;
+        }
+
+        // Pass the datum up through the frames it completes.
+        while (true) {
+            if (frames.empty()) {
+                return datum;
+            }
+            auto& frame = frames.back();
+            if (frame.is_quote) {
+                auto quote =
+                    MakeCell(conser, MakeSymbol(conser, "quote"), MakeCell(conser, datum));
+                SetPosition(quote.get(), frame, conser);
+                datum = std::move(quote);
+                frames.pop_back();
+                continue;
+            }
+
+            frame.elements.push_back(std::move(datum));
+            if (tokenizer->IsEnd()) {
+                throw SyntaxError{"No closing bracket!"};
+            }
+            if (!IsCloseBracket(tokenizer->GetToken())) {
+                StartElement(tokenizer, &frame);
+                break;
+            }
+            tokenizer->Next();  // Skip close bracket
+            datum = FinishList(&frame, conser);
+            frames.pop_back();
+        }
+    }
+}
@@ -1,8 +1,38 @@
 #pragma once
 
-#include <memory>
+#include <string_view>
 
 #include "object.h"
 #include <tokenizer.h>
 
-std::shared_ptr<Object> Read(Tokenizer* tokenizer);
\ No newline at end of file
+class HashConser;
+
+// Reads one datum. Nesting depth is limited by the heap, not by the native stack.
+// If |conser| is set, identical subterms are shared through it.
+Handle<Object> Read(Tokenizer* tokenizer, HashConser* conser = nullptr);
+
+// Yields the top-level forms of |input| one at a time without copying it, so
+// large inputs can be evaluated form by form.
+class Reader {
+public:
+    // |input| must outlive the reader, as well as |conser| if it's set.
+    explicit Reader(std::string_view input, HashConser* conser = nullptr)
+        : tokenizer_(input), conser_(conser) {
+    }
+
+    bool IsEnd() {
+        return tokenizer_.IsEnd();
+    }
+
+    Handle<Object> ReadForm() {
+        return Read(&tokenizer_, conser_);
+    }
+
+    SourcePosition GetPosition() {
+        return tokenizer_.GetPosition();
+    }
+
+private:
+    Tokenizer tokenizer_;
+    HashConser* conser_;
+};
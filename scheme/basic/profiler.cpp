@@ -0,0 +1,135 @@
+#ifdef SCHEME_PROFILING
+
+#include "profiler.h"
+#include <algorithm>
+#include <iomanip>
+#include <string>
+#include <utility>
+
+namespace {
+
+double ToMilliseconds(std::chrono::nanoseconds time) {
+    return std::chrono::duration<double, std::milli>(time).count();
+}
+
+template <class Key>
+std::vector<std::pair<Key, Profiler::Stats>> SortBySelfTime(
+    const auto& stats) {
+    std::vector<std::pair<Key, Profiler::Stats>> ans(stats.begin(), stats.end());
+    std::ranges::stable_sort(ans, [](const auto& lhs, const auto& rhs) {
+        return lhs.second.self > rhs.second.self;
+    });
+    return ans;
+}
+
+void WriteStats(std::ostream* out, const Profiler::Stats& stats) {
+    *out << std::setw(10) << stats.calls << std::setw(12) << ToMilliseconds(stats.total)
+         << std::setw(12) << ToMilliseconds(stats.self) << std::setw(10) << stats.allocations;
+}
+
+}  // namespace
+
+Profiler& Profiler::Local() {
+    thread_local Profiler profiler;
+    return profiler;
+}
+
+void Profiler::Enter(SymbolId function, const SourcePosition& position) {
+    auto parent = frames_.empty() ? 0 : frames_.back().node;
+    auto [it, inserted] = stack_children_.try_emplace({parent, function}, stack_nodes_.size());
+    if (inserted) {
+        stack_nodes_.push_back({parent, function});
+    }
+    frames_.push_back({function, {position.line, position.column, function}, it->second});
+    ++depth_[function];
+    frames_.back().start = Clock::now();
+}
+
+void Profiler::Exit() {
+    const auto& frame = frames_.back();
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - frame.start);
+    auto self = elapsed - frame.children;
+
+    // Recursive calls are already covered by the total time of the outermost one.
+    bool outermost = --depth_[frame.function] == 0;
+    for (auto* stats : {&functions_[frame.function], &sites_[frame.site]}) {
+        ++stats->calls;
+        stats->self += self;
+        if (outermost) {
+            stats->total += elapsed;
+        }
+    }
+    stack_nodes_[frame.node].self += self;
+
+    frames_.pop_back();
+    if (!frames_.empty()) {
+        frames_.back().children += elapsed;
+    }
+}
+
+void Profiler::CountAllocation() {
+    if (frames_.empty()) {
+        ++unattributed_allocations_;
+        return;
+    }
+    ++functions_[frames_.back().function].allocations;
+    ++sites_[frames_.back().site].allocations;
+}
+
+void Profiler::Reset() {
+    functions_.clear();
+    sites_.clear();
+    for (auto& node : stack_nodes_) {
+        node.self = {};
+    }
+    unattributed_allocations_ = 0;
+}
+
+void Profiler::WriteFlatProfile(std::ostream* out) const {
+    const auto& symbols = SymbolTable::Instance();
+    *out << std::fixed << std::setprecision(3);
+
+    *out << std::left << std::setw(16) << "builtin" << std::right << std::setw(10) << "calls"
+         << std::setw(12) << "total ms" << std::setw(12) << "self ms" << std::setw(10)
+         << "allocs" << "\n";
+    for (const auto& [function, stats] : SortBySelfTime<SymbolId>(functions_)) {
+        *out << std::left << std::setw(16) << symbols.GetName(function) << std::right;
+        WriteStats(out, stats);
+        *out << "\n";
+    }
+    *out << std::left << std::setw(16) << "(outside calls)" << std::right << std::setw(44)
+         << unattributed_allocations_ << "\n\n";
+
+    *out << std::left << std::setw(16) << "call site" << std::right << std::setw(10) << "calls"
+         << std::setw(12) << "total ms" << std::setw(12) << "self ms" << std::setw(10)
+         << "allocs" << "\n";
+    for (const auto& [site, stats] : SortBySelfTime<Site>(sites_)) {
+        const auto& [line, column, function] = site;
+        auto name = std::to_string(line) + ":" + std::to_string(column) + " " +
+                    symbols.GetName(function);
+        *out << std::left << std::setw(16) << name << std::right;
+        WriteStats(out, stats);
+        *out << "\n";
+    }
+}
+
+void Profiler::WriteFoldedStacks(std::ostream* out) const {
+    const auto& symbols = SymbolTable::Instance();
+    for (size_t i = 1; i < stack_nodes_.size(); ++i) {
+        if (stack_nodes_[i].self == std::chrono::nanoseconds::zero()) {
+            continue;
+        }
+        std::vector<SymbolId> stack;
+        for (auto node = i; node != 0; node = stack_nodes_[node].parent) {
+            stack.push_back(stack_nodes_[node].function);
+        }
+        for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
+            *out << (it == stack.rbegin() ? "" : ";") << symbols.GetName(*it);
+        }
+        *out << " "
+             << std::chrono::duration_cast<std::chrono::microseconds>(stack_nodes_[i].self).count()
+             << "\n";
+    }
+}
+
+#endif
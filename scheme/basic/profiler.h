@@ -0,0 +1,103 @@
+#pragma once
+
+// Opt-in evaluator profiler. It is compiled in only with -DSCHEME_PROFILING;
+// otherwise the SCHEME_PROFILE_* hooks expand to nothing and cost nothing.
+
+#ifdef SCHEME_PROFILING
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "source_position.h"
+#include "symbol_table.h"
+
+// Profile of the builtin calls made by the current thread: call counts,
+// cumulative and self time and allocations per builtin and per call site.
+class Profiler {
+public:
+    struct Stats {
+        size_t calls = 0;
+        size_t allocations = 0;
+        std::chrono::nanoseconds total{};
+        std::chrono::nanoseconds self{};
+    };
+
+    static Profiler& Local();
+
+    void Enter(SymbolId function, const SourcePosition& position);
+    void Exit();
+
+    // Attributes an allocation to the innermost active call.
+    void CountAllocation();
+
+    void Reset();
+
+    const std::unordered_map<SymbolId, Stats>& GetFunctions() const {
+        return functions_;
+    }
+
+    // Table of builtins and then of call sites, each sorted by self time.
+    void WriteFlatProfile(std::ostream* out) const;
+
+    // One "outer;inner self_us" line per call stack, the input of flamegraph.pl.
+    void WriteFoldedStacks(std::ostream* out) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    // line, column and the builtin called there
+    using Site = std::tuple<size_t, size_t, SymbolId>;
+
+    // Call stacks form a tree, so a call only has to find its node under the
+    // node of its caller.
+    struct StackNode {
+        size_t parent;
+        SymbolId function;
+        std::chrono::nanoseconds self{};
+    };
+
+    struct Frame {
+        SymbolId function;
+        Site site;
+        size_t node;
+        Clock::time_point start{};
+        std::chrono::nanoseconds children{};
+    };
+
+    std::unordered_map<SymbolId, Stats> functions_;
+    std::map<Site, Stats> sites_;
+    std::vector<StackNode> stack_nodes_ = {{0, 0}};  // the root is an empty stack
+    std::map<std::pair<size_t, SymbolId>, size_t> stack_children_;
+    std::unordered_map<SymbolId, size_t> depth_;  // active calls, for recursive total time
+    std::vector<Frame> frames_;
+    size_t unattributed_allocations_ = 0;
+};
+
+class ProfileScope {
+public:
+    ProfileScope(SymbolId function, const SourcePosition& position) {
+        Profiler::Local().Enter(function, position);
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+    ~ProfileScope() {
+        Profiler::Local().Exit();
+    }
+};
+
+#define SCHEME_PROFILE_CALL(function, position) \
+    ProfileScope scheme_profile_scope((function), (position))
+#define SCHEME_PROFILE_ALLOCATION() Profiler::Local().CountAllocation()
+
+#else
+
+#define SCHEME_PROFILE_CALL(function, position)
+#define SCHEME_PROFILE_ALLOCATION()
+
+#endif
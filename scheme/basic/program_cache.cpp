@@ -0,0 +1,73 @@
+#include "program_cache.h"
+#include <functional>
+#include <utility>
+#include "compiler.h"
+
+const Program& CachedProgram::GetProgram() const {
+    std::call_once(compiled_, [this] {
+        HeapScope scope(heap_.get());
+        program_ = Compile(ast_);
+    });
+    return program_;
+}
+
+size_t ProgramCache::KeyHash::operator()(const Key& key) const {
+    auto hash = std::hash<std::string_view>{}(key.source);
+    for (const void* ptr : {static_cast<const void*>(key.options.optimizer),
+                            static_cast<const void*>(key.options.conser)}) {
+        hash ^= std::hash<const void*>{}(ptr) + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+    }
+    return hash;
+}
+
+ProgramCache::ProgramCache(size_t max_size) : max_size_(max_size) {
+}
+
+std::shared_ptr<const CachedProgram> ProgramCache::Get(std::string_view source,
+                                                       const Options& options) {
+    std::scoped_lock lock(mutex_);
+    auto it = map_.find({source, options});
+    if (it == map_.end()) {
+        ++stats_.misses;
+        return nullptr;
+    }
+
+    ++stats_.hits;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->program;
+}
+
+std::shared_ptr<const CachedProgram> ProgramCache::Put(std::string source,
+                                                       const Options& options,
+                                                       std::unique_ptr<Heap> heap,
+                                                       Handle<Object> ast) {
+    auto cached = std::make_shared<const CachedProgram>(std::move(heap), ast);
+
+    std::scoped_lock lock(mutex_);
+    if (auto it = map_.find({source, options}); it != map_.end()) {
+        // Another thread got here first, keep its entry.
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->program;
+    }
+    if (max_size_ == 0) {
+        return cached;
+    }
+
+    entries_.push_front({std::move(source), options, cached});
+    map_.emplace(Key{entries_.front().source, options}, entries_.begin());
+    while (entries_.size() > max_size_) {
+        map_.erase({entries_.back().source, entries_.back().options});
+        entries_.pop_back();
+    }
+    return cached;
+}
+
+ProgramCache::Stats ProgramCache::GetStats() const {
+    std::scoped_lock lock(mutex_);
+    return stats_;
+}
+
+size_t ProgramCache::Size() const {
+    std::scoped_lock lock(mutex_);
+    return entries_.size();
+}
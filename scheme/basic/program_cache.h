@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include "bytecode.h"
+#include "heap.h"
+
+class HashConser;
+class Object;
+class Optimizer;
+
+// Parsed form together with its bytecode, which is compiled on first use, so
+// tree-walking interpreters never compile. The program keeps the heap its AST
+// was read onto, which is never collected. Thread-safe.
+class CachedProgram {
+public:
+    CachedProgram(std::unique_ptr<Heap> heap, Handle<Object> ast)
+        : heap_(std::move(heap)), ast_(ast) {
+    }
+
+    Handle<Object> GetAst() const {
+        return ast_;
+    }
+
+    const Program& GetProgram() const;
+
+private:
+    std::unique_ptr<Heap> heap_;
+    Handle<Object> ast_;
+    mutable std::once_flag compiled_;
+    mutable Program program_;
+};
+
+// Bounded LRU cache of parsed and compiled programs. The AST depends on how the
+// source was read and optimized, so programs are keyed by the source text
+// together with the optimizer and the hash conser used for it; interpreters
+// with different ones never see each other's programs. All methods are
+// thread-safe, so one cache can be shared by many interpreters.
+class ProgramCache {
+public:
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+    };
+
+    explicit ProgramCache(size_t max_size);
+
+    // Either may be null. A hash conser has to outlive the programs cached
+    // with it.
+    struct Options {
+        const Optimizer* optimizer = nullptr;
+        const HashConser* conser = nullptr;
+
+        bool operator==(const Options& other) const = default;
+    };
+
+    // Returns nullptr if |source| isn't cached with |options|.
+    std::shared_ptr<const CachedProgram> Get(std::string_view source, const Options& options);
+
+    // Caches |ast| for |source| read with |options|, evicting the least recently
+    // used entry if the cache is full. |heap| holds |ast| and nothing else.
+    std::shared_ptr<const CachedProgram> Put(std::string source, const Options& options,
+                                             std::unique_ptr<Heap> heap, Handle<Object> ast);
+
+    Stats GetStats() const;
+
+    size_t Size() const;
+
+private:
+    struct Entry {
+        std::string source;
+        Options options;
+        std::shared_ptr<const CachedProgram> program;
+    };
+
+    // Points into the source of its entry.
+    struct Key {
+        std::string_view source;
+        Options options;
+
+        bool operator==(const Key& other) const = default;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    size_t max_size_;
+    mutable std::mutex mutex_;
+    std::list<Entry> entries_;  // most recently used first
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> map_;
+    Stats stats_;
+};
@@ -1,22 +1,140 @@
 #include "scheme.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <memory>
-#include <sstream>
+#include <utility>
+#include <thread>
+#include "compiler.h"
 #include "error.h"
+#include "heap.h"
+#include "mapped_file.h"
 #include "object.h"
+#include "optimizer.h"
 #include "parser.h"
+#include "program_cache.h"
 #include "tokenizer.h"
+#include "vm.h"
 
 std::string Interpreter::Run(const std::string& s) {
-    std::stringstream ss;
-    ss << s;
-    auto tokenizer = std::make_unique<Tokenizer>(&ss);
-    auto ast = Read(tokenizer.get());
+    // Whatever the program allocates is garbage once its result is written out.
+    Heap heap;
+    HeapScope scope(&heap);
+
+    std::string out;
+    if (!cache_) {
+        Tokenizer tokenizer(std::string_view{s});
+        Evaluate(Optimize(Read(&tokenizer, conser_)), nullptr, &out);
+        return out;
+    }
+
+    ProgramCache::Options options{.optimizer = optimizer_, .conser = conser_};
+    auto cached = cache_->Get(s, options);
+    if (!cached) {
+        auto program_heap = std::make_unique<Heap>();
+        Handle<Object> ast;
+        {
+            HeapScope program_scope(program_heap.get());
+            Tokenizer tokenizer(std::string_view{s});
+            ast = Optimize(Read(&tokenizer, conser_));
+        }
+        if (optimizer_) {
+            // Drops what constant folding left behind.
+            Object* roots[] = {ast.get()};
+            program_heap->Collect(roots);
+        }
+        cached = cache_->Put(s, options, std::move(program_heap), ast);
+    }
+    Evaluate(cached->GetAst(), cached.get(), &out);
+    return out;
+}
+
+void Interpreter::RunForms(std::string_view input,
+                           const std::function<void(const std::string&)>& callback) {
+    // A single buffer is reused for the results of all forms.
+    Reader reader(input, conser_);
+    std::string out;
+    Heap heap;
+    HeapScope scope(&heap);
+    while (!reader.IsEnd()) {
+        out.clear();
+        Evaluate(Optimize(reader.ReadForm()), nullptr, &out);
+        callback(out);
+        // Nothing of a form is needed once its result is written out.
+        if (heap.ShouldCollect()) {
+            heap.Collect({});
+        }
+    }
+}
+
+void Interpreter::RunFile(const std::string& path,
+                          const std::function<void(const std::string&)>& callback) {
+    MappedFile file(path);
+    RunForms(file.GetData(), callback);
+}
+
+std::vector<std::string> Interpreter::RunBatch(std::span<const std::string> programs,
+                                               size_t threads) {
+    if (threads == 0) {
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    threads = std::min(threads, programs.size());
+
+    std::vector<std::string> results(programs.size());
+    std::vector<std::exception_ptr> errors(programs.size());
+    std::atomic<size_t> next = 0;
+    std::atomic_bool failed = false;
+
+    // Programs are claimed in order, so once one fails every earlier program has
+    // already been claimed and the first recorded error is the first one overall.
+    auto worker = [&] {
+        for (size_t i; !failed && (i = next.fetch_add(1)) < programs.size();) {
+            try {
+                results[i] = Run(programs[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threads; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    return results;
+}
+
+Handle<Object> Interpreter::Optimize(Handle<Object> ast) {
+    return optimizer_ ? optimizer_->Optimize(ast) : ast;
+}
+
+void Interpreter::Evaluate(const Handle<Object>& ast, const CachedProgram* cached,
+                           std::string* out) {
     if (!ast) {
         throw RuntimeError("Empty ast!");
     }
-    auto evaluated_ast = ast->Evaluate();
+    Handle<Object> evaluated_ast;
+    if (mode_ == EvaluationMode::TREE_WALK) {
+        evaluated_ast = ast->Evaluate();
+    } else if (cached) {
+        evaluated_ast = Vm{}.Run(cached->GetProgram()).ToObject();
+    } else {
+        evaluated_ast = Vm{}.Run(Compile(ast)).ToObject();
+    }
     if (!evaluated_ast) {
-        return "()";
+        out->append("()");
+    } else {
+        evaluated_ast->SerializeTo(out);
     }
-    return evaluated_ast->Serialize();
 }
@@ -1,11 +1,66 @@
 #pragma once
 
 #include <cstdint>
-#include <memory>
+#include <functional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "heap.h"
+
+class Object;
+class HashConser;
+class Optimizer;
+class CachedProgram;
+class ProgramCache;
+
+enum class EvaluationMode {
+    TREE_WALK,  // reference mode: evaluates the AST directly
+    BYTECODE    // compiles the AST and runs it on Vm
+};
+
+// Every call evaluates on a heap of its own, which is freed when it returns.
+// Garbage is collected between the forms of RunForms and, in bytecode mode,
+// between VM instructions; a form evaluated by the tree walker keeps what it
+// allocates until it is done.
 class Interpreter {
 public:
+    // If |cache| is set, Run looks programs up there before parsing them. If
+    // |optimizer| is set, every form is passed through it before evaluation. If
+    // |conser| is set, the reader shares identical data through it. All of them
+    // must outlive the interpreter and may be shared between threads.
+    explicit Interpreter(EvaluationMode mode = EvaluationMode::BYTECODE,
+                         ProgramCache* cache = nullptr, Optimizer* optimizer = nullptr,
+                         HashConser* conser = nullptr)
+        : mode_(mode), cache_(cache), optimizer_(optimizer), conser_(conser) {
+    }
+
     std::string Run(const std::string&);
+
+    // Evaluates the top-level forms of |input| one by one and passes every result
+    // to |callback|. Forms already evaluated are garbage, so memory doesn't grow
+    // with the input.
+    void RunForms(std::string_view input, const std::function<void(const std::string&)>& callback);
+
+    // Same as RunForms for a memory-mapped file.
+    void RunFile(const std::string& path, const std::function<void(const std::string&)>& callback);
+
+    // Evaluates independent |programs| on up to |threads| worker threads (all
+    // hardware threads by default) and returns their results in order. Every
+    // thread allocates from its own heap; if some programs fail, the error of
+    // the first one is rethrown.
+    std::vector<std::string> RunBatch(std::span<const std::string> programs, size_t threads = 0);
+
+private:
+    Handle<Object> Optimize(Handle<Object> ast);
+
+    // Appends the result to |out|. Runs the bytecode of |cached| instead of
+    // compiling |ast| if it's given.
+    void Evaluate(const Handle<Object>& ast, const CachedProgram* cached, std::string* out);
+
+    EvaluationMode mode_;
+    ProgramCache* cache_;
+    Optimizer* optimizer_;
+    HashConser* conser_;
 };
@@ -0,0 +1,91 @@
+// Object::SerializeTo on large lists. Not part of a build target, from this
+// directory:
+//   g++ -std=c++20 -O2 -I. -c $(ls *.cpp | grep -v '_benchmark\|_test')
+//   g++ -std=c++20 -O2 -pthread serialize_benchmark.cpp *.o -o serialize_benchmark
+//   ./serialize_benchmark [elements]
+//
+// numbers:  a flat list of |elements| numbers.
+// mixed:    the same with a sublist (a #t) after every third number.
+// nested:   a number inside |elements| nested lists.
+// improper: |elements| numbers ending in a dotted pair.
+// Every list is written over and over for a fixed time, into a fresh string as
+// Serialize does and into a reused buffer as RunForms does.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "heap.h"
+#include "object.h"
+#include "parser.h"
+#include "tokenizer.h"
+
+namespace {
+
+constexpr std::chrono::milliseconds kDuration{500};
+
+std::string MakeList(const std::string& shape, int elements) {
+    if (shape == "nested") {
+        return std::string(elements, '(') + "7" + std::string(elements, ')');
+    }
+    std::string list = "(";
+    for (int i = 0; i < elements; ++i) {
+        list += std::to_string(i % 2000 * 7919 - 1000000);
+        list += shape == "mixed" && i % 3 == 0 ? " (a #t) " : " ";
+    }
+    list.back() = ')';
+    if (shape == "improper") {
+        list.insert(list.size() - 1, " . 0");
+    }
+    return list;
+}
+
+// Milliseconds per call of |pass|.
+double Measure(const std::function<void()>& pass) {
+    size_t passes = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double, std::milli> elapsed{};
+    while (elapsed < kDuration) {
+        pass();
+        ++passes;
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    return elapsed.count() / passes;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    auto elements = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    if (elements < 1) {
+        std::fprintf(stderr, "usage: %s [elements]\n", argv[0]);
+        return 1;
+    }
+
+    Heap heap;
+    HeapScope scope(&heap);
+    std::printf("%d elements\n", elements);
+    std::printf("%10s %12s %12s %12s %12s\n", "list", "MB", "fresh ms", "reused ms", "MB/s");
+    for (const char* shape : {"numbers", "mixed", "nested", "improper"}) {
+        auto source = MakeList(shape, elements);
+        Tokenizer tokenizer{std::string_view(source)};
+        auto list = Read(&tokenizer);
+        if (list->Serialize() != source) {
+            std::fprintf(stderr, "%s: output differs from the input\n", shape);
+            return 1;
+        }
+
+        auto fresh = Measure([&] { list->Serialize(); });
+        std::string buffer;
+        auto reused = Measure([&] {
+            buffer.clear();
+            list->SerializeTo(&buffer);
+        });
+        std::printf("%10s %12.1f %12.2f %12.2f %12.1f\n", shape, buffer.size() / 1e6, fresh,
+                    reused, buffer.size() / 1e3 / reused);
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <utility>
+
+// Contiguous container keeping up to N elements inline. Used for argument
+// lists, which are short in almost every call.
+template <class T, size_t N>
+class SmallVector {
+public:
+    SmallVector() = default;
+
+    SmallVector(const SmallVector&) = delete;
+    SmallVector& operator=(const SmallVector&) = delete;
+
+    SmallVector(SmallVector&& other) {
+        if (other.IsInline()) {
+            std::uninitialized_move(other.begin(), other.end(), begin());
+            size_ = other.size_;
+            other.clear();
+        } else {
+            data_ = std::exchange(other.data_, other.GetInline());
+            size_ = std::exchange(other.size_, 0);
+            capacity_ = std::exchange(other.capacity_, N);
+        }
+    }
+
+    SmallVector& operator=(SmallVector&&) = delete;
+
+    ~SmallVector() {
+        clear();
+        if (!IsInline()) {
+            std::allocator<T>{}.deallocate(data_, capacity_);
+        }
+    }
+
+    template <class... Args>
+    T& emplace_back(Args&&... args) {
+        if (size_ == capacity_) {
+            Reallocate(capacity_ * 2);
+        }
+        auto ptr = std::construct_at(data_ + size_, std::forward<Args>(args)...);
+        ++size_;
+        return *ptr;
+    }
+
+    void push_back(T value) {
+        emplace_back(std::move(value));
+    }
+
+    void pop_back() {
+        std::destroy_at(data_ + --size_);
+    }
+
+    void clear() {
+        std::destroy(begin(), end());
+        size_ = 0;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    T& operator[](size_t idx) {
+        return data_[idx];
+    }
+    const T& operator[](size_t idx) const {
+        return data_[idx];
+    }
+
+    T& front() {
+        return data_[0];
+    }
+    T& back() {
+        return data_[size_ - 1];
+    }
+
+    T* begin() {
+        return data_;
+    }
+    T* end() {
+        return data_ + size_;
+    }
+    const T* begin() const {
+        return data_;
+    }
+    const T* end() const {
+        return data_ + size_;
+    }
+
+    operator std::span<T>() {
+        return {data_, size_};
+    }
+
+private:
+    T* GetInline() {
+        return std::launder(reinterpret_cast<T*>(inline_));
+    }
+
+    bool IsInline() const {
+        return capacity_ == N;
+    }
+
+    void Reallocate(size_t capacity) {
+        auto data = std::allocator<T>{}.allocate(capacity);
+        std::uninitialized_move(begin(), end(), data);
+        std::destroy(begin(), end());
+        if (!IsInline()) {
+            std::allocator<T>{}.deallocate(data_, capacity_);
+        }
+        data_ = data;
+        capacity_ = capacity;
+    }
+
+    alignas(T) std::byte inline_[N * sizeof(T)];
+    T* data_ = GetInline();
+    size_t size_ = 0;
+    size_t capacity_ = N;
+};
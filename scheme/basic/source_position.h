@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+
+// Position of the first character of a token, line and column are 1-based.
+struct SourcePosition {
+    size_t offset = 0;
+    size_t line = 1;
+    size_t column = 1;
+
+    bool operator==(const SourcePosition& other) const = default;
+};
@@ -3,6 +3,22 @@ add_library(scheme_basic
     parser.cpp
     scheme.cpp
     object.cpp
+    compiler.cpp
+    vm.cpp
+    symbol_table.cpp
+    mapped_file.cpp
+    program_cache.cpp
+    bigint.cpp
+    optimizer.cpp
+    profiler.cpp
+    hash_cons.cpp
+    heap.cpp
     
     # maybe more .cpp files here
 )
+
+# Evaluator profiler, see profiler.h. Off by default and free when off.
+option(SCHEME_PROFILING "Build the Scheme evaluator profiler" OFF)
+if (SCHEME_PROFILING)
+    target_compile_definitions(scheme_basic PUBLIC SCHEME_PROFILING)
+endif()
@@ -0,0 +1,100 @@
+#include "symbol_table.h"
+#include <bit>
+#include <functional>
+#include <utility>
+
+namespace {
+
+// Block and offset in it of the name with |id|.
+std::pair<size_t, size_t> Locate(SymbolId id, size_t first_block) {
+    auto position = id + first_block;
+    auto block = std::bit_width(position) - std::bit_width(first_block);
+    return {block, position - (first_block << block)};
+}
+
+}  // namespace
+
+SymbolTable& SymbolTable::Instance() {
+    static SymbolTable table;
+    return table;
+}
+
+SymbolTable::SymbolTable() {
+    indexes_.push_back(std::make_unique<Index>(kFirstBlock));
+    index_ = indexes_.back().get();
+}
+
+SymbolTable::~SymbolTable() {
+    for (auto& block : blocks_) {
+        delete[] block.load();
+    }
+}
+
+SymbolId SymbolTable::Intern(std::string_view name) {
+    auto hash = std::hash<std::string_view>{}(name);
+    SymbolId id;
+    if (Find(*index_.load(std::memory_order_acquire), name, hash, &id)) {
+        return id;
+    }
+
+    std::scoped_lock lock(mutex_);
+    auto index = index_.load(std::memory_order_relaxed);
+    if (Find(*index, name, hash, &id)) {
+        return id;
+    }
+    id = static_cast<SymbolId>(names_.size());
+    const auto& interned = names_.emplace_back(name);
+
+    auto [block, offset] = Locate(id, kFirstBlock);
+    if (offset == 0) {
+        blocks_[block].store(new const std::string*[kFirstBlock << block],
+                             std::memory_order_release);
+    }
+    blocks_[block].load(std::memory_order_relaxed)[offset] = &interned;
+
+    if (2 * names_.size() > index->mask + 1) {
+        auto larger = std::make_unique<Index>(2 * (index->mask + 1));
+        for (SymbolId i = 0; i < id; ++i) {
+            Insert(larger.get(), &names_[i], std::hash<std::string_view>{}(names_[i]), i);
+        }
+        index = larger.get();
+        indexes_.push_back(std::move(larger));
+        index_.store(index, std::memory_order_release);
+    }
+    Insert(index, &interned, hash, id);
+    size_.store(names_.size(), std::memory_order_release);
+    return id;
+}
+
+const std::string& SymbolTable::GetName(SymbolId id) const {
+    auto [block, offset] = Locate(id, kFirstBlock);
+    return *blocks_[block].load(std::memory_order_acquire)[offset];
+}
+
+size_t SymbolTable::Size() const {
+    return size_.load(std::memory_order_acquire);
+}
+
+bool SymbolTable::Find(const Index& index, std::string_view name, size_t hash, SymbolId* id) {
+    for (auto i = hash & index.mask;; i = (i + 1) & index.mask) {
+        auto entry = index.slots[i].name.load(std::memory_order_acquire);
+        if (!entry) {
+            return false;
+        }
+        if (*entry == name) {
+            *id = index.slots[i].id.load(std::memory_order_relaxed);
+            return true;
+        }
+    }
+}
+
+// Only called under the lock. The id is stored first, so readers that see the
+// name see its id too.
+void SymbolTable::Insert(Index* index, const std::string* name, size_t hash, SymbolId id) {
+    auto i = hash & index->mask;
+    while (index->slots[i].name.load(std::memory_order_relaxed)) {
+        i = (i + 1) & index->mask;
+    }
+    index->slots[i].id.store(id, std::memory_order_relaxed);
+    index->slots[i].name.store(name, std::memory_order_release);
+}
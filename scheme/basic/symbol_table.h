@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using SymbolId = uint32_t;
+
+// Process-wide interner mapping symbol names to small integer ids.
+// Interned names live as long as the table, so references to them stay valid.
+//
+// Looking up names interned before and GetName don't lock, only adding a name
+// does. Names are never removed, so the table holds every distinct name of the
+// sources parsed by the process, taking up to about 200 bytes per name besides
+// its characters. Symbols are only made by the parser: a process evaluating a
+// fixed set of sources stops growing, one evaluating ever new names doesn't.
+class SymbolTable {
+public:
+    static SymbolTable& Instance();
+
+    SymbolId Intern(std::string_view name);
+
+    const std::string& GetName(SymbolId id) const;
+
+    size_t Size() const;
+
+    ~SymbolTable();
+
+private:
+    // Open addressing hash table of the names, replaced by a twice larger copy
+    // when half full. Readers may still use a replaced one, so those are kept.
+    struct Slot {
+        std::atomic<const std::string*> name;
+        std::atomic<SymbolId> id;
+    };
+    struct Index {
+        explicit Index(size_t size) : mask(size - 1), slots(new Slot[size]()) {
+        }
+
+        size_t mask;
+        std::unique_ptr<Slot[]> slots;
+    };
+
+    // Names by id are stored in blocks of kFirstBlock, 2 * kFirstBlock, ...
+    // names, so a block never moves once allocated.
+    static constexpr size_t kFirstBlock = 64;
+    static constexpr size_t kBlocks = 32;
+
+    SymbolTable();
+
+    static bool Find(const Index& index, std::string_view name, size_t hash, SymbolId* id);
+    static void Insert(Index* index, const std::string* name, size_t hash, SymbolId id);
+
+    std::atomic<Index*> index_;
+    std::array<std::atomic<const std::string**>, kBlocks> blocks_{};
+    std::atomic<size_t> size_ = 0;
+
+    std::mutex mutex_;  // taken to add names
+    std::deque<std::string> names_;
+    std::vector<std::unique_ptr<Index>> indexes_;
+};
+
+inline SymbolId Intern(std::string_view name) {
+    return SymbolTable::Instance().Intern(name);
+}
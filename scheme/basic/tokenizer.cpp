@@ -1,123 +1,158 @@
 #include <tokenizer.h>
 #include <cctype>
 #include <cstddef>
-#include <cstdio>
 #include <iterator>
-#include <regex>
+#include <limits>
 #include <string_view>
+#include "error.h"
 
-Token Tokenizer::GetToken() {
-    if (auto token = GetToken<ConstantToken>()) {
-        return *token;
-    }
-    if (auto token = GetToken<SymbolToken>()) {
-        return *token;
+namespace {
+
+enum class CharClass : uint8_t {
+    OTHER,
+    SPACE,
+    DIGIT,
+    PLUS,
+    MINUS,
+    SYMBOL_START,  // may start and continue a symbol
+    SYMBOL_TAIL,   // may only continue a symbol
+    QUOTE,
+    DOT,
+    OPEN,
+    CLOSE,
+    COUNT
+};
+
+constexpr auto kCharClasses = [] {
+    std::array<CharClass, 256> classes{};
+    for (int c = 0; c < 256; ++c) {
+        if (c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f') {
+            classes[c] = CharClass::SPACE;
+        } else if ('0' <= c && c <= '9') {
+            classes[c] = CharClass::DIGIT;
+        } else if (('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z')) {
+            classes[c] = CharClass::SYMBOL_START;
+        }
     }
-    if (auto token = GetToken<QuoteToken>()) {
-        return *token;
+    for (char c : std::string_view("<=>*/#")) {
+        classes[c] = CharClass::SYMBOL_START;
     }
-    if (auto token = GetToken<DotToken>()) {
-        return *token;
+    classes['?'] = classes['!'] = CharClass::SYMBOL_TAIL;
+    classes['+'] = CharClass::PLUS;
+    classes['-'] = CharClass::MINUS;
+    classes['\''] = CharClass::QUOTE;
+    classes['.'] = CharClass::DOT;
+    classes['('] = CharClass::OPEN;
+    classes[')'] = CharClass::CLOSE;
+    return classes;
+}();
+
+constexpr size_t kStates = 9;
+constexpr size_t kClasses = static_cast<size_t>(CharClass::COUNT);
+
+// kTransitions[state][class] is the next state, ERROR stops the scan.
+// Tokens: numbers are [+-]?[0-9]+, symbols are [+-] or
+// [a-zA-Z<=>*/#][a-zA-Z<=>*/#0-9?!-]*, the rest are single characters.
+template <class S>
+constexpr auto MakeTransitions() {
+    std::array<std::array<S, kClasses>, kStates> table;
+    for (auto& row : table) {
+        row.fill(S::ERROR);
     }
-    if (auto token = GetToken<BracketToken>()) {
-        return *token;
+    auto set = [&table](S from, CharClass c, S to) {
+        table[static_cast<size_t>(from)][static_cast<size_t>(c)] = to;
+    };
+    set(S::START, CharClass::DIGIT, S::NUMBER);
+    set(S::START, CharClass::PLUS, S::SIGN);
+    set(S::START, CharClass::MINUS, S::SIGN);
+    set(S::START, CharClass::SYMBOL_START, S::SYMBOL);
+    set(S::START, CharClass::QUOTE, S::QUOTE);
+    set(S::START, CharClass::DOT, S::DOT);
+    set(S::START, CharClass::OPEN, S::OPEN);
+    set(S::START, CharClass::CLOSE, S::CLOSE);
+    set(S::SIGN, CharClass::DIGIT, S::NUMBER);
+    set(S::NUMBER, CharClass::DIGIT, S::NUMBER);
+    for (auto c : {CharClass::DIGIT, CharClass::MINUS, CharClass::SYMBOL_START,
+                   CharClass::SYMBOL_TAIL}) {
+        set(S::SYMBOL, c, S::SYMBOL);
     }
-
-    assert(false);
+    return table;
 }
 
-template <>
-std::regex Tokenizer::GetRegex<SymbolToken>() {
-    return std::regex(R"(([a-zA-Z<=>*\/#][a-zA-Z<=>*\/#0-9?!-]*)|([+-]))");
-}
-template <>
-std::regex Tokenizer::GetRegex<QuoteToken>() {
-    return std::regex(R"(['])");
-}
-template <>
-std::regex Tokenizer::GetRegex<DotToken>() {
-    return std::regex(R"([.])");
-}
-template <>
-std::regex Tokenizer::GetRegex<BracketToken>() {
-    return std::regex(R"([()])");
-}
-template <>
-std::regex Tokenizer::GetRegex<ConstantToken>() {
-    return std::regex(R"([+-]?\d+)");
-}
+}  // namespace
 
-template <>
-SymbolToken Tokenizer::Create<SymbolToken>(const std::string& match) {
-    return SymbolToken{match};
-}
-template <>
-QuoteToken Tokenizer::Create<QuoteToken>([[maybe_unused]] const std::string& match) {
-    return QuoteToken{};
+Tokenizer::Tokenizer(std::istream* in)
+    : buffer_(std::istreambuf_iterator<char>(*in), std::istreambuf_iterator<char>()),
+      input_(buffer_) {
 }
-template <>
-DotToken Tokenizer::Create<DotToken>([[maybe_unused]] const std::string& match) {
-    return DotToken{};
-}
-template <>
-BracketToken Tokenizer::Create<BracketToken>(const std::string& match) {
-    if (match[0] == '(') {
-        return BracketToken::OPEN;
+
+Tokenizer::Match Tokenizer::Scan() const {
+    static constexpr auto kTransitions = MakeTransitions<State>();
+
+    auto state = State::START;
+    size_t size = 0;
+    for (auto it = input_.begin() + position_.offset; it != input_.end(); ++it, ++size) {
+        auto next = kTransitions[static_cast<size_t>(state)]
+                                [static_cast<size_t>(kCharClasses[static_cast<uint8_t>(*it)])];
+        if (next == State::ERROR) {
+            break;
+        }
+        state = next;
     }
-    return BracketToken::CLOSE;
-}
-template <>
-ConstantToken Tokenizer::Create<ConstantToken>(const std::string& match) {
-    return ConstantToken{std::stoi(match)};
+    return {size, state};
 }
 
-template <class TokenType>
-std::optional<TokenType> Tokenizer::GetToken() {
+Token Tokenizer::GetToken() {
     SkipWhitespace();
-    if (auto match = GetMatch<TokenType>()) {
-        return Create<TokenType>(*match);
+    auto [size, state] = Scan();
+    auto text = input_.substr(position_.offset, size);
+    switch (state) {
+        case State::NUMBER: {
+            bool negative = text[0] == '-';
+            int64_t limit = int64_t{std::numeric_limits<int>::max()} + negative;
+            int64_t value = 0;
+            for (char c : text.substr(negative || text[0] == '+')) {
+                value = value * 10 + (c - '0');
+                if (value > limit) {
+                    throw SyntaxError("Number is too big!");
+                }
+            }
+            return ConstantToken{static_cast<int>(negative ? -value : value)};
+        }
+        case State::SIGN:
+        case State::SYMBOL:
+            return SymbolToken{std::string(text)};
+        case State::QUOTE:
+            return QuoteToken{};
+        case State::DOT:
+            return DotToken{};
+        case State::OPEN:
+            return BracketToken::OPEN;
+        case State::CLOSE:
+            return BracketToken::CLOSE;
+        default:
+            throw SyntaxError("Unexpected character!");
     }
-    return {};
 }
 
-template <class TokenType>
-std::optional<std::string> Tokenizer::GetMatch() {
-    static const auto kRegex = GetRegex<TokenType>();
-
-    std::smatch match;
-
-    if (std::string next = GetNextWord();
-        std::regex_search(next, match, kRegex, std::regex_constants::match_continuous)) {
-        return match.str();
+void Tokenizer::SkipWhitespace() {
+    while (position_.offset < input_.size() &&
+           kCharClasses[static_cast<uint8_t>(input_[position_.offset])] == CharClass::SPACE) {
+        Advance({1, State::START});
     }
-    return {};
 }
 
-size_t Tokenizer::SkipSize() {
-    if (auto match = GetMatch<QuoteToken>()) {
-        return match->size();
+void Tokenizer::Advance(Match match) {
+    if (match.size == 0) {
+        throw SyntaxError("Unexpected character!");
     }
-    if (auto match = GetMatch<DotToken>()) {
-        return match->size();
+    for (auto c : input_.substr(position_.offset, match.size)) {
+        if (c == '\n') {
+            ++position_.line;
+            position_.column = 1;
+        } else {
+            ++position_.column;
+        }
     }
-    if (auto match = GetMatch<BracketToken>()) {
-        return match->size();
-    }
-    if (auto match = GetMatch<ConstantToken>()) {
-        return match->size();
-    }
-    if (auto match = GetMatch<SymbolToken>()) {
-        return match->size();
-    }
-    return 0;
+    position_.offset += match.size;
 }
-
-std::string Tokenizer::GetNextWord() {
-    auto save = in_->tellg();
-
-    std::string s;
-    (*in_) >> s;
-
-    in_->seekg(save);
-    return s;
-}
\ No newline at end of file
@@ -3,10 +3,14 @@
 #include <array>
 #include <cassert>
 #include <cstddef>
-#include <regex>
+#include <cstdint>
 #include <variant>
 #include <optional>
 #include <istream>
+#include <string>
+#include <string_view>
+
+#include "source_position.h"
 
 struct SymbolToken {
     std::string name;
@@ -33,48 +37,55 @@ struct ConstantToken {
 
 using Token = std::variant<ConstantToken, BracketToken, SymbolToken, QuoteToken, DotToken>;
 
+// Single-pass lexer over a contiguous buffer driven by a character class
+// table and a small DFA.
 class Tokenizer {
 public:
-    Tokenizer(std::istream* in) : in_(in) {
+    // Reads the whole stream into an owned buffer.
+    Tokenizer(std::istream* in);
+
+    // |input| must outlive the tokenizer.
+    explicit Tokenizer(std::string_view input) : input_(input) {
     }
 
+    Tokenizer(const Tokenizer&) = delete;
+    Tokenizer& operator=(const Tokenizer&) = delete;
+
     bool IsEnd() {
         SkipWhitespace();
-        return in_->eof();
+        return position_.offset == input_.size();
     }
 
     void Next() {
-        auto cur = in_->tellg();
-        cur += SkipSize();
-        in_->seekg(cur);
+        SkipWhitespace();
+        Advance(Scan());
     }
 
     Token GetToken();
 
-private:
-    template <class TokenType>
-    static std::regex GetRegex();
-
-    template <class TokenType>
-    static TokenType Create(const std::string& s);
+    // Position of the token returned by GetToken.
+    SourcePosition GetPosition() {
+        SkipWhitespace();
+        return position_;
+    }
 
-    template <class TokenType>
-    std::optional<TokenType> GetToken();
+private:
+    enum class State : uint8_t { START, SIGN, NUMBER, SYMBOL, QUOTE, DOT, OPEN, CLOSE, ERROR };
 
-    template <class TokenType>
-    std::optional<std::string> GetMatch();
+    // Length of the longest token starting at the current position and the
+    // state the DFA stopped in.
+    struct Match {
+        size_t size;
+        State state;
+    };
 
-    size_t SkipSize();
+    Match Scan() const;
 
-    void SkipWhitespace() {
-        auto next = in_->peek();
-        while (next == ' ' || next == '\n') {
-            in_->ignore();
-            next = in_->peek();
-        }
-    }
+    void SkipWhitespace();
 
-    std::string GetNextWord();
+    void Advance(Match match);
 
-    std::istream* in_;
-};
\ No newline at end of file
+    std::string buffer_;
+    std::string_view input_;
+    SourcePosition position_;
+};
@@ -0,0 +1,270 @@
+// Tokenizer throughput against the regex tokenizer over std::istream it replaced.
+// Not part of a build target, from this directory:
+//   g++ -std=c++20 -O2 -I. -c $(ls *.cpp | grep -v '_benchmark\|_test')
+//   g++ -std=c++20 -O2 -pthread tokenizer_benchmark.cpp *.o -o tokenizer_benchmark
+//   ./tokenizer_benchmark [kilobytes]
+//
+// The input repeats a few lines of numbers, symbols, quotes and brackets. Every
+// tokenizer reads all of its tokens over and over for a fixed time; the new one
+// both from a string_view and from a stream it copies into its buffer first.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <istream>
+#include <iterator>
+#include <optional>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tokenizer.h"
+
+namespace {
+
+constexpr std::chrono::milliseconds kDuration{500};
+
+// The tokenizer of f5f5e95, only renamed and with the missing return after the
+// last token type turned into an abort.
+class IstreamTokenizer {
+public:
+    IstreamTokenizer(std::istream* in) : in_(in) {
+    }
+
+    bool IsEnd() {
+        SkipWhitespace();
+        return in_->eof();
+    }
+
+    void Next() {
+        auto cur = in_->tellg();
+        cur += SkipSize();
+        in_->seekg(cur);
+    }
+
+    Token GetToken();
+
+private:
+    template <class TokenType>
+    static std::regex GetRegex();
+
+    template <class TokenType>
+    static TokenType Create(const std::string& s);
+
+    template <class TokenType>
+    std::optional<TokenType> GetToken();
+
+    template <class TokenType>
+    std::optional<std::string> GetMatch();
+
+    size_t SkipSize();
+
+    void SkipWhitespace() {
+        auto next = in_->peek();
+        while (next == ' ' || next == '\n') {
+            in_->ignore();
+            next = in_->peek();
+        }
+    }
+
+    std::string GetNextWord();
+
+    std::istream* in_;
+};
+
+Token IstreamTokenizer::GetToken() {
+    if (auto token = GetToken<ConstantToken>()) {
+        return *token;
+    }
+    if (auto token = GetToken<SymbolToken>()) {
+        return *token;
+    }
+    if (auto token = GetToken<QuoteToken>()) {
+        return *token;
+    }
+    if (auto token = GetToken<DotToken>()) {
+        return *token;
+    }
+    if (auto token = GetToken<BracketToken>()) {
+        return *token;
+    }
+
+    std::abort();
+}
+
+template <>
+std::regex IstreamTokenizer::GetRegex<SymbolToken>() {
+    return std::regex(R"(([a-zA-Z<=>*\/#][a-zA-Z<=>*\/#0-9?!-]*)|([+-]))");
+}
+template <>
+std::regex IstreamTokenizer::GetRegex<QuoteToken>() {
+    return std::regex(R"(['])");
+}
+template <>
+std::regex IstreamTokenizer::GetRegex<DotToken>() {
+    return std::regex(R"([.])");
+}
+template <>
+std::regex IstreamTokenizer::GetRegex<BracketToken>() {
+    return std::regex(R"([()])");
+}
+template <>
+std::regex IstreamTokenizer::GetRegex<ConstantToken>() {
+    return std::regex(R"([+-]?\d+)");
+}
+
+template <>
+SymbolToken IstreamTokenizer::Create<SymbolToken>(const std::string& match) {
+    return SymbolToken{match};
+}
+template <>
+QuoteToken IstreamTokenizer::Create<QuoteToken>([[maybe_unused]] const std::string& match) {
+    return QuoteToken{};
+}
+template <>
+DotToken IstreamTokenizer::Create<DotToken>([[maybe_unused]] const std::string& match) {
+    return DotToken{};
+}
+template <>
+BracketToken IstreamTokenizer::Create<BracketToken>(const std::string& match) {
+    if (match[0] == '(') {
+        return BracketToken::OPEN;
+    }
+    return BracketToken::CLOSE;
+}
+template <>
+ConstantToken IstreamTokenizer::Create<ConstantToken>(const std::string& match) {
+    return ConstantToken{std::stoi(match)};
+}
+
+template <class TokenType>
+std::optional<TokenType> IstreamTokenizer::GetToken() {
+    SkipWhitespace();
+    if (auto match = GetMatch<TokenType>()) {
+        return Create<TokenType>(*match);
+    }
+    return {};
+}
+
+template <class TokenType>
+std::optional<std::string> IstreamTokenizer::GetMatch() {
+    static const auto kRegex = GetRegex<TokenType>();
+
+    std::smatch match;
+
+    if (std::string next = GetNextWord();
+        std::regex_search(next, match, kRegex, std::regex_constants::match_continuous)) {
+        return match.str();
+    }
+    return {};
+}
+
+size_t IstreamTokenizer::SkipSize() {
+    if (auto match = GetMatch<QuoteToken>()) {
+        return match->size();
+    }
+    if (auto match = GetMatch<DotToken>()) {
+        return match->size();
+    }
+    if (auto match = GetMatch<BracketToken>()) {
+        return match->size();
+    }
+    if (auto match = GetMatch<ConstantToken>()) {
+        return match->size();
+    }
+    if (auto match = GetMatch<SymbolToken>()) {
+        return match->size();
+    }
+    return 0;
+}
+
+std::string IstreamTokenizer::GetNextWord() {
+    auto save = in_->tellg();
+
+    std::string s;
+    (*in_) >> s;
+
+    in_->seekg(save);
+    return s;
+}
+
+std::string MakeInput(size_t bytes) {
+    static constexpr const char* kLines[] = {
+        "(define (fact n) (if (< n 2) 1 (* n (fact (- n 1)))))\n",
+        "(list-ref '(1 2 (abc def) -15 +7 x?) (+ 1 2))\n",
+        "(cons 'a (quote (b . c))) (set-car! pair 12345) (null? '())\n",
+        "(and (<= 1 2 3) (not #f) (>= -100 -200) (max 1 2 3 4 5 6 7 8 9))\n",
+    };
+    std::string input;
+    for (size_t i = 0; input.size() < bytes; ++i) {
+        input += kLines[i % std::size(kLines)];
+    }
+    return input;
+}
+
+// Megabytes per second of |pass|, which tokenizes |bytes| bytes.
+double Measure(size_t bytes, const std::function<void()>& pass) {
+    size_t passes = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed{};
+    while (elapsed < kDuration) {
+        pass();
+        ++passes;
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    return passes * bytes / elapsed.count() / 1e6;
+}
+
+template <class T>
+std::vector<Token> ReadAll(T* tokenizer) {
+    std::vector<Token> tokens;
+    while (!tokenizer->IsEnd()) {
+        tokens.push_back(tokenizer->GetToken());
+        tokenizer->Next();
+    }
+    return tokens;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    auto kilobytes = argc > 1 ? std::atoi(argv[1]) : 256;
+    if (kilobytes < 1) {
+        std::fprintf(stderr, "usage: %s [kilobytes]\n", argv[0]);
+        return 1;
+    }
+
+    auto input = MakeInput(kilobytes * 1024);
+    std::vector<Token> tokens;
+    {
+        std::istringstream stream(input);
+        IstreamTokenizer tokenizer(&stream);
+        tokens = ReadAll(&tokenizer);
+    }
+    {
+        Tokenizer tokenizer{std::string_view(input)};
+        if (ReadAll(&tokenizer) != tokens) {
+            std::fprintf(stderr, "tokens differ\n");
+            return 1;
+        }
+    }
+
+    std::printf("%zu bytes, %zu tokens, MB/s\n", input.size(), tokens.size());
+    std::printf("%-16s %10.2f\n", "istream regex", Measure(input.size(), [&] {
+                    std::istringstream stream(input);
+                    IstreamTokenizer tokenizer(&stream);
+                    ReadAll(&tokenizer);
+                }));
+    std::printf("%-16s %10.2f\n", "dfa istream", Measure(input.size(), [&] {
+                    std::istringstream stream(input);
+                    Tokenizer tokenizer(&stream);
+                    ReadAll(&tokenizer);
+                }));
+    std::printf("%-16s %10.2f\n", "dfa string_view", Measure(input.size(), [&] {
+                    Tokenizer tokenizer{std::string_view(input)};
+                    ReadAll(&tokenizer);
+                }));
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+#include "object.h"
+
+// Evaluated value as seen by Vm. Small integers, booleans and the empty list
+// are immediates that never touch the heap; everything else refers to an Object.
+// Objects are only created when a value escapes to the tree-walking world
+// (see ToObject).
+class Value {
+public:
+    enum class Tag : uint8_t { EMPTY, FIXNUM, BOOLEAN, OBJECT };
+
+    Value() = default;
+
+    explicit Value(Handle<Object> obj) {
+        if (!obj) {
+            return;
+        }
+        if (auto number = As<Number>(obj)) {
+            tag_ = Tag::FIXNUM;
+            fixnum_ = number->GetValue();
+        } else if (auto symbol = As<Symbol>(obj); symbol && symbol->IsBoolean()) {
+            tag_ = Tag::BOOLEAN;
+            fixnum_ = static_cast<bool>(*symbol);
+        } else {
+            tag_ = Tag::OBJECT;
+            object_ = obj.get();
+        }
+    }
+
+    static Value Fixnum(int64_t value) {
+        Value ans;
+        ans.tag_ = Tag::FIXNUM;
+        ans.fixnum_ = value;
+        return ans;
+    }
+
+    static Value Boolean(bool value) {
+        Value ans;
+        ans.tag_ = Tag::BOOLEAN;
+        ans.fixnum_ = value;
+        return ans;
+    }
+
+    Tag GetTag() const {
+        return tag_;
+    }
+
+    bool IsEmpty() const {
+        return tag_ == Tag::EMPTY;
+    }
+    bool IsFixnum() const {
+        return tag_ == Tag::FIXNUM;
+    }
+    bool IsBoolean() const {
+        return tag_ == Tag::BOOLEAN;
+    }
+
+    int64_t GetFixnum() const {
+        return fixnum_;
+    }
+
+    // Heap object behind the value, nullptr for immediates.
+    Handle<Object> GetObject() const {
+        return Handle<Object>(tag_ == Tag::OBJECT ? object_ : nullptr);
+    }
+
+    // Everything except #f is true.
+    explicit operator bool() const {
+        switch (tag_) {
+            case Tag::BOOLEAN:
+                return fixnum_;
+            case Tag::OBJECT:
+                return static_cast<bool>(*object_);
+            default:
+                return true;
+        }
+    }
+
+    Handle<Object> ToObject() const {
+        switch (tag_) {
+            case Tag::FIXNUM:
+                return New<Number>(fixnum_);
+            case Tag::BOOLEAN:
+                return Symbol::GetBoolean(fixnum_);
+            case Tag::OBJECT:
+                return Handle<Object>(object_);
+            default:
+                return nullptr;
+        }
+    }
+
+private:
+    // 16 bytes with nothing to destroy, so values are passed and returned in
+    // registers.
+    Tag tag_ = Tag::EMPTY;
+    union {
+        int64_t fixnum_ = 0;
+        Object* object_;
+    };
+};
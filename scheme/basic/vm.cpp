@@ -0,0 +1,72 @@
+#include "vm.h"
+#include <cassert>
+#include <cstddef>
+#include <span>
+#include "error.h"
+#include "profiler.h"
+
+Value Vm::Run(const Program& program) {
+    stack_.clear();
+    auto& heap = Heap::Current();
+
+    for (size_t pc = 0; pc < program.code.size(); ++pc) {
+        const auto& instruction = program.code[pc];
+        switch (instruction.opcode) {
+            case Opcode::PUSH_CONSTANT:
+                stack_.push_back(program.constants[instruction.operand]);
+                break;
+            case Opcode::APPLY: {
+                SCHEME_PROFILE_CALL(instruction.function->GetId(), instruction.position);
+                auto first = stack_.size() - instruction.operand;
+                auto result = instruction.function->Apply(
+                    std::span(stack_).subspan(first, instruction.operand));
+                stack_.resize(first);
+                stack_.push_back(std::move(result));
+                MaybeCollect(program, &heap);
+                break;
+            }
+            case Opcode::CALL: {
+                SCHEME_PROFILE_CALL(instruction.function->GetId(), instruction.position);
+                stack_.emplace_back(instruction.function->Evaluate(
+                    program.constants[instruction.operand].ToObject()));
+                MaybeCollect(program, &heap);
+                break;
+            }
+            case Opcode::JUMP_IF_TRUE_OR_POP:
+                if (stack_.back()) {
+                    pc = instruction.operand - 1;
+                } else {
+                    stack_.pop_back();
+                }
+                break;
+            case Opcode::JUMP_IF_FALSE_OR_POP:
+                if (!stack_.back()) {
+                    pc = instruction.operand - 1;
+                } else {
+                    stack_.pop_back();
+                }
+                break;
+            case Opcode::RAISE:
+                throw RuntimeError(program.messages[instruction.operand]);
+        }
+    }
+
+    assert(stack_.size() == 1);
+    auto result = std::move(stack_.back());
+    stack_.pop_back();
+    return result;
+}
+
+void Vm::MaybeCollect(const Program& program, Heap* heap) {
+    if (!heap->ShouldCollect()) [[likely]] {
+        return;
+    }
+    roots_.clear();
+    for (const auto& value : stack_) {
+        roots_.push_back(value.GetObject().get());
+    }
+    for (const auto& value : program.constants) {
+        roots_.push_back(value.GetObject().get());
+    }
+    heap->Collect(roots_);
+}
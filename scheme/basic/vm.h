@@ -0,0 +1,21 @@
+#pragma once
+
+#include <vector>
+
+#include "bytecode.h"
+#include "heap.h"
+#include "value.h"
+
+// Stack machine executing programs produced by Compiler. Objects are allocated
+// on the current heap, which is collected between instructions once enough has
+// been allocated; the stack and the constants of the program are the roots.
+class Vm {
+public:
+    Value Run(const Program& program);
+
+private:
+    void MaybeCollect(const Program& program, Heap* heap);
+
+    std::vector<Value> stack_;
+    std::vector<Object*> roots_;
+};
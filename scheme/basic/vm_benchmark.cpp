@@ -0,0 +1,95 @@
+// Tree walker against bytecode VM. Not part of a build target, from this
+// directory:
+//   g++ -std=c++20 -O2 -pthread -I. vm_benchmark.cpp $(ls *.cpp | grep -v '_benchmark\|_test')
+//   ./vm_benchmark [terms]
+//
+// arith: a sum of |terms| products of differences, sums, max and min of small
+//        numbers.
+// list:  a sum of |terms| elements picked from freshly built 32-element lists
+//        with list-tail, cdr, car and list-ref.
+//
+// Every program runs over and over for a fixed time in both modes, once read
+// from a ProgramCache, so only evaluation is timed, and once parsed on every run.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <utility>
+
+#include "program_cache.h"
+#include "scheme.h"
+
+namespace {
+
+constexpr std::chrono::milliseconds kDuration{500};
+
+std::string MakeArithmetic(int terms) {
+    std::string sum = "(+";
+    for (int i = 0; i < terms; ++i) {
+        auto n = std::to_string(i % 100);
+        sum += " (* (- " + n + " 3) (+ " + n + " 1) (max " + n + " 2 (- 7 " + n + ")) (min " +
+               n + " 50))";
+    }
+    sum += ')';
+    return sum;
+}
+
+std::string MakeList(int terms) {
+    std::string numbers;
+    for (int i = 0; i < 32; ++i) {
+        numbers += ' ' + std::to_string(i);
+    }
+    std::string sum = "(+";
+    for (int i = 0; i < terms; ++i) {
+        auto n = std::to_string(i % 30);
+        sum += " (+ (list-ref (cdr (list-tail (list" + numbers + ") " + n +
+               ")) 1) (car (cdr (list" + numbers + "))))";
+    }
+    sum += ')';
+    return sum;
+}
+
+// Runs per second of |run|.
+double Measure(const std::function<void()>& run) {
+    size_t runs = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed{};
+    while (elapsed < kDuration) {
+        run();
+        ++runs;
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    return runs / elapsed.count();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    auto terms = argc > 1 ? std::atoi(argv[1]) : 1000;
+    if (terms < 1) {
+        std::fprintf(stderr, "usage: %s [terms]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("%d terms, runs/s\n", terms);
+    std::printf("%8s %10s %12s %12s %12s\n", "program", "mode", "cached", "parsed", "result");
+    for (auto [name, program] :
+         {std::pair{"arith", MakeArithmetic(terms)}, std::pair{"list", MakeList(terms)}}) {
+        for (auto mode : {EvaluationMode::TREE_WALK, EvaluationMode::BYTECODE}) {
+            ProgramCache cache(1);
+            Interpreter cached(mode, &cache);
+            Interpreter parsed(mode);
+            auto result = parsed.Run(program);
+            if (cached.Run(program) != result) {
+                std::fprintf(stderr, "%s: cached result differs\n", name);
+                return 1;
+            }
+            std::printf("%8s %10s %12.1f %12.1f %12s\n", name,
+                        mode == EvaluationMode::TREE_WALK ? "tree-walk" : "bytecode",
+                        Measure([&] { cached.Run(program); }),
+                        Measure([&] { parsed.Run(program); }), result.c_str());
+        }
+    }
+}